@@ -5,12 +5,59 @@
 
 __C {
     __export void llaisysAdd(llaisysTensor_t c, llaisysTensor_t a, llaisysTensor_t b);
+    // residual += in, then out = llaisysRmsNorm(residual), in one pass over each row. out, residual and
+    // in are contiguous [rows, dim] of one dtype and out may be in; weight may use another dtype.
+    __export void llaisysAddRmsNorm(llaisysTensor_t out, llaisysTensor_t residual, llaisysTensor_t in, llaisysTensor_t weight, float eps);
     __export void llaisysArgmax(llaisysTensor_t max_idx, llaisysTensor_t max_val, llaisysTensor_t vals);
     __export void llaisysEmbedding(llaisysTensor_t out, llaisysTensor_t index, llaisysTensor_t weight);
+    // weight_scale / weight_zero as in llaisysLinearQuantized
+    __export void llaisysEmbeddingQuantized(llaisysTensor_t out, llaisysTensor_t index, llaisysTensor_t weight, llaisysTensor_t weight_scale, llaisysTensor_t weight_zero);
+    // Writes k [n, nkvhead, d] and v [n, nkvhead, dv] as tokens pos .. pos + n - 1 of a paged cache
+    // laid out as in llaisysPagedAttention, converting to the cache dtype. An I8 cache is quantized
+    // per (token, kv head) with F32 k_scale / v_scale [num_blocks, block_size, nkvhead]; other caches
+    // take NULL scales. Heads of a token must be contiguous, the token stride is free.
+    __export void llaisysKVAppend(llaisysTensor_t k_cache, llaisysTensor_t v_cache, llaisysTensor_t k_scale, llaisysTensor_t v_scale, llaisysTensor_t k, llaisysTensor_t v, llaisysTensor_t block_table, size_t pos);
     __export void llaisysLinear(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, llaisysTensor_t bias);
+    // out = alpha * (in * dequant(weight)^T) + bias + residual, computed in one pass.
+    // weight_scale / weight_zero / bias / residual may be NULL. residual is shaped like out and
+    // may be out itself, which accumulates the projection into it.
+    __export void llaisysLinearEpilogue(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, llaisysTensor_t weight_scale, llaisysTensor_t weight_zero, llaisysTensor_t bias, llaisysTensor_t residual, float alpha);
+    // Returns a new tensor holding the F32/BF16/F16/I8 weight [N, K] prepacked for the linear
+    // kernels. It keeps the logical shape and can be passed as the weight of the linear ops, but
+    // not to ops that expect a strided tensor. Destroy it with tensorDestroy.
+    __export llaisysTensor_t llaisysLinearPackWeight(llaisysTensor_t weight);
+    // weight holds interleaved rows (gate_0, up_0, gate_1, up_1, ...) of shape [2 * I, K]; out is
+    // [M, I] = silu(in * W_gate^T) * (in * W_up^T). weight_scale / weight_zero may be NULL for
+    // float weights, otherwise as in llaisysLinearQuantized.
+    __export void llaisysLinearSwiGLU(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, llaisysTensor_t weight_scale, llaisysTensor_t weight_zero);
+    // Causal attention like llaisysSelfAttention over the last total_len positions of a paged cache:
+    // k_cache [num_blocks, block_size, nkvhead, d] and v_cache [num_blocks, block_size, nkvhead, dv]
+    // hold key t in block block_table[t / block_size] (I32), row t % block_size.
+    // The caches may be F32/BF16/F16 independently of q, or I8 with the scales written by
+    // llaisysKVAppend; k_scale / v_scale are NULL otherwise.
+    __export void llaisysPagedAttention(llaisysTensor_t attn_val, llaisysTensor_t q, llaisysTensor_t k_cache, llaisysTensor_t v_cache, llaisysTensor_t k_scale, llaisysTensor_t v_scale, llaisysTensor_t block_table, size_t total_len, float scale);
+    // Quantized weight from llaisysQuantize:
+    //   I8 [N, K] with a [N] F32 weight_scale and no weight_zero
+    //   U8 packed q4 [N, K / 2] with a [N, K / group] F16 weight_scale and an optional
+    //   [N, K / group] U8 weight_zero (NULL for symmetric groups)
+    __export void llaisysLinearQuantized(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, llaisysTensor_t weight_scale, llaisysTensor_t weight_zero, llaisysTensor_t bias);
+    // out dtype selects the format: I8 per-row, or U8 packed q4 whose group size is K / scale.shape[1].
+    // zero may be NULL; it is only valid (and selects asymmetric groups) for q4.
+    __export void llaisysQuantize(llaisysTensor_t out, llaisysTensor_t scale, llaisysTensor_t zero, llaisysTensor_t in);
     __export void llaisysRearrange(llaisysTensor_t out, llaisysTensor_t in);
     __export void llaisysRmsNorm(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, float eps);
     __export void llaisysROPE(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t pos_ids, float theta);
+    // Same as llaisysROPE, reading cos/sin from a table filled by llaisysROPETable; the results are
+    // bit-identical. Every position must be a row of the table.
+    __export void llaisysROPEWithTable(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t pos_ids, llaisysTensor_t table);
+    // Fills an F32 table [max_pos, 2, head_dim / 2]: row p holds cos(p * f_j) followed by sin(p * f_j),
+    // f_j = theta^(-2j / head_dim).
+    __export void llaisysROPETable(llaisysTensor_t table, float theta);
+    // llaisysROPEWithTable on q (into q_out, which may be q) and k followed by llaisysKVAppend of
+    // the rotated k and v, in one pass. Token i of q / k / v is at position pos + i; q is
+    // [n, nhead, d] of the k/v dtype with contiguous heads. The cache holds the same bits as the
+    // separate calls would write.
+    __export void llaisysROPEKVAppend(llaisysTensor_t q_out, llaisysTensor_t k_cache, llaisysTensor_t v_cache, llaisysTensor_t k_scale, llaisysTensor_t v_scale, llaisysTensor_t q, llaisysTensor_t k, llaisysTensor_t v, llaisysTensor_t table, llaisysTensor_t block_table, size_t pos);
     __export void llaisysSelfAttention(llaisysTensor_t attn_val, llaisysTensor_t q, llaisysTensor_t k, llaisysTensor_t v, float scale);
     __export void llaisysSwiGLU(llaisysTensor_t out, llaisysTensor_t gate, llaisysTensor_t up);
 }
@@ -42,6 +42,14 @@ __C {
 
     // Llaisys API for switching device context
     __export void llaisysSetContextRuntime(llaisysDeviceType_t, int);
+
+    // Llaisys API for the worker threads shared by all cpu kernels.
+    // The count includes the calling thread; 0 means one per hardware thread.
+    __export void llaisysSetNumThreads(size_t num_threads);
+    __export size_t llaisysGetNumThreads();
+    // Pin workers round-robin to cpu_ids[1..ncpu), cpu_ids[0] is left to the calling thread.
+    // With ncpu < 2 the workers are unpinned.
+    __export void llaisysSetThreadAffinity(const int *cpu_ids, size_t ncpu);
 }
 
 #endif // LLAISYS_RUNTIME_H
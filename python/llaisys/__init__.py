@@ -1,4 +1,5 @@
 from .runtime import RuntimeAPI
+from .runtime import set_num_threads, get_num_threads, set_thread_affinity
 from .libllaisys import DeviceType
 from .libllaisys import DataType
 from .libllaisys import MemcpyKind
@@ -10,6 +11,9 @@ from .models import *
 
 __all__ = [
     "RuntimeAPI",
+    "set_num_threads",
+    "get_num_threads",
+    "set_thread_affinity",
     "DeviceType",
     "DataType",
     "MemcpyKind",
@@ -1,5 +1,6 @@
 import ctypes
 from ..common import _LIB
+from ..llaisys_types import llaisysDataType_t
 
 # 1. 定义与 C++ 对应的配置结构体
 class Qwen2Config(ctypes.Structure):
@@ -11,11 +12,35 @@ class Qwen2Config(ctypes.Structure):
         ("n_heads", ctypes.c_int),
         ("n_kv_heads", ctypes.c_int),
         ("max_seq_len", ctypes.c_int),
+        # 权重的加载时量化: 0 不量化, 1 投影层 INT8 每通道, 2 Q4 分组 (含 embed/lm_head)
+        ("weight_quant", ctypes.c_int),
+        ("quant_group_size", ctypes.c_int),
+        ("quant_zero_point", ctypes.c_int),
+        # prefill 每块最多的 token 数 (激活缓冲区按它分配)，0 表示默认值 256
+        ("prefill_chunk_size", ctypes.c_int),
+        # 分页 KV cache 每个 block 的 token 数，0 表示默认值 16
+        ("kv_block_size", ctypes.c_int),
+        # KV cache 的存储类型 (F32/BF16/F16/I8)，0 表示 F32
+        ("kv_cache_dtype", llaisysDataType_t),
+        # 跨请求前缀缓存的 KV 上限 (MB)，0 表示不启用
+        ("prefix_cache_mb", ctypes.c_int),
+        # KV cache block 池的大小 (MB)，构造时一次分配; 0 表示默认值 1024
+        ("kv_cache_mb", ctypes.c_int),
         # 注意：float 类型的 rope_theta 和 rms_norm_eps 在 C++ 构造函数内部处理了，
         # 或者如果你在 C 结构体里加了，这里也要加。
         # 根据之前的 C++ 代码，我们传递的是简化的 ConfigC，没有 float 字段。
     ]
 
+class Qwen2PrefixCacheStats(ctypes.Structure):
+    _fields_ = [
+        ("lookups", ctypes.c_size_t),
+        ("hits", ctypes.c_size_t),
+        ("lookup_tokens", ctypes.c_size_t),
+        ("hit_tokens", ctypes.c_size_t),
+        ("evicted_blocks", ctypes.c_size_t),
+        ("cached_blocks", ctypes.c_size_t),
+    ]
+
 # 2. 绑定 C++ 导出的函数
 # qwen2_model_t qwen2_create(const Qwen2ConfigC* config)
 _LIB.qwen2_create.argtypes = [ctypes.POINTER(Qwen2Config)]
@@ -25,16 +50,91 @@ _LIB.qwen2_create.restype = ctypes.c_void_p
 _LIB.qwen2_destroy.argtypes = [ctypes.c_void_p]
 _LIB.qwen2_destroy.restype = None
 
-# void qwen2_load_tensor(qwen2_model_t model, const char* name, const void* data)
-_LIB.qwen2_load_tensor.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_void_p]
+# void qwen2_load_tensor(qwen2_model_t model, const char* name, const void* data, llaisysDataType_t dtype)
+_LIB.qwen2_load_tensor.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_void_p, llaisysDataType_t]
 _LIB.qwen2_load_tensor.restype = None
 
 # int qwen2_forward(qwen2_model_t model, int token, int pos)
 _LIB.qwen2_forward.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_int]
 _LIB.qwen2_forward.restype = ctypes.c_int
 
+# int qwen2_prefill(qwen2_model_t model, const int64_t* tokens, size_t ntoken, int pos)
+_LIB.qwen2_prefill.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_int64), ctypes.c_size_t, ctypes.c_int]
+_LIB.qwen2_prefill.restype = ctypes.c_int
+
+# int qwen2_prefill_sequence(qwen2_model_t model, int seq_id, const int64_t* tokens, size_t ntoken, int pos)
+_LIB.qwen2_prefill_sequence.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.POINTER(ctypes.c_int64), ctypes.c_size_t, ctypes.c_int]
+_LIB.qwen2_prefill_sequence.restype = ctypes.c_int
+
+# int qwen2_forward_batch(qwen2_model_t model, const int* seq_ids, const int64_t* tokens, const int* positions, size_t n, int* next_tokens)
+_LIB.qwen2_forward_batch.argtypes = [
+    ctypes.c_void_p,
+    ctypes.POINTER(ctypes.c_int),
+    ctypes.POINTER(ctypes.c_int64),
+    ctypes.POINTER(ctypes.c_int),
+    ctypes.c_size_t,
+    ctypes.POINTER(ctypes.c_int),
+]
+_LIB.qwen2_forward_batch.restype = ctypes.c_int
+
+# void qwen2_release_sequence(qwen2_model_t model, int seq_id)
+_LIB.qwen2_release_sequence.argtypes = [ctypes.c_void_p, ctypes.c_int]
+_LIB.qwen2_release_sequence.restype = None
+
+# void qwen2_prefix_cache_stats(qwen2_model_t model, Qwen2PrefixCacheStatsC* stats)
+_LIB.qwen2_prefix_cache_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(Qwen2PrefixCacheStats)]
+_LIB.qwen2_prefix_cache_stats.restype = None
+
+# int qwen2_save_session(qwen2_model_t model, const char* path)
+_LIB.qwen2_save_session.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+_LIB.qwen2_save_session.restype = ctypes.c_int
+
+# int qwen2_load_session(qwen2_model_t model, const char* path, int64_t* tokens, size_t capacity)
+_LIB.qwen2_load_session.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.POINTER(ctypes.c_int64), ctypes.c_size_t]
+_LIB.qwen2_load_session.restype = ctypes.c_int
+
+# qwen2_scheduler_t qwen2_scheduler_create(qwen2_model_t model, int max_batch, int prefill_budget)
+_LIB.qwen2_scheduler_create.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_int]
+_LIB.qwen2_scheduler_create.restype = ctypes.c_void_p
+
+# void qwen2_scheduler_destroy(qwen2_scheduler_t scheduler)
+_LIB.qwen2_scheduler_destroy.argtypes = [ctypes.c_void_p]
+_LIB.qwen2_scheduler_destroy.restype = None
+
+# int64_t qwen2_scheduler_submit(qwen2_scheduler_t scheduler, const int64_t* prompt, size_t ntoken, size_t max_new_tokens, int64_t eos_token)
+_LIB.qwen2_scheduler_submit.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_int64), ctypes.c_size_t, ctypes.c_size_t, ctypes.c_int64]
+_LIB.qwen2_scheduler_submit.restype = ctypes.c_int64
+
+# int qwen2_scheduler_poll(qwen2_scheduler_t scheduler, int64_t request_id, int64_t* tokens, size_t capacity, int timeout_ms, int* finished, int* failed)
+_LIB.qwen2_scheduler_poll.argtypes = [
+    ctypes.c_void_p,
+    ctypes.c_int64,
+    ctypes.POINTER(ctypes.c_int64),
+    ctypes.c_size_t,
+    ctypes.c_int,
+    ctypes.POINTER(ctypes.c_int),
+    ctypes.POINTER(ctypes.c_int),
+]
+_LIB.qwen2_scheduler_poll.restype = ctypes.c_int
+
+# void qwen2_scheduler_cancel(qwen2_scheduler_t scheduler, int64_t request_id)
+_LIB.qwen2_scheduler_cancel.argtypes = [ctypes.c_void_p, ctypes.c_int64]
+_LIB.qwen2_scheduler_cancel.restype = None
+
 # 为了方便主代码调用，导出这些函数
 qwen2_create = _LIB.qwen2_create
 qwen2_destroy = _LIB.qwen2_destroy
 qwen2_load_tensor = _LIB.qwen2_load_tensor
-qwen2_forward = _LIB.qwen2_forward
\ No newline at end of file
+qwen2_forward = _LIB.qwen2_forward
+qwen2_prefill = _LIB.qwen2_prefill
+qwen2_prefill_sequence = _LIB.qwen2_prefill_sequence
+qwen2_forward_batch = _LIB.qwen2_forward_batch
+qwen2_release_sequence = _LIB.qwen2_release_sequence
+qwen2_prefix_cache_stats = _LIB.qwen2_prefix_cache_stats
+qwen2_save_session = _LIB.qwen2_save_session
+qwen2_load_session = _LIB.qwen2_load_session
+qwen2_scheduler_create = _LIB.qwen2_scheduler_create
+qwen2_scheduler_destroy = _LIB.qwen2_scheduler_destroy
+qwen2_scheduler_submit = _LIB.qwen2_scheduler_submit
+qwen2_scheduler_poll = _LIB.qwen2_scheduler_poll
+qwen2_scheduler_cancel = _LIB.qwen2_scheduler_cancel
@@ -1,19 +1,99 @@
 from .tensor import llaisysTensor_t
-from ctypes import c_float
+from ctypes import c_float, c_size_t
 
 def load_ops(lib):
     lib.llaisysAdd.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
     lib.llaisysAdd.restype = None
 
+    lib.llaisysAddRmsNorm.argtypes = [
+        llaisysTensor_t,  # out
+        llaisysTensor_t,  # residual
+        llaisysTensor_t,  # in
+        llaisysTensor_t,  # weight
+        c_float,  # eps
+    ]
+    lib.llaisysAddRmsNorm.restype = None
+
     lib.llaisysArgmax.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
     lib.llaisysArgmax.restype = None
 
     lib.llaisysEmbedding.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
     lib.llaisysEmbedding.restype = None
 
+    lib.llaisysEmbeddingQuantized.argtypes = [
+        llaisysTensor_t,  # out
+        llaisysTensor_t,  # index
+        llaisysTensor_t,  # weight
+        llaisysTensor_t,  # weight_scale
+        llaisysTensor_t,  # weight_zero
+    ]
+    lib.llaisysEmbeddingQuantized.restype = None
+
+    lib.llaisysKVAppend.argtypes = [
+        llaisysTensor_t,  # k_cache
+        llaisysTensor_t,  # v_cache
+        llaisysTensor_t,  # k_scale
+        llaisysTensor_t,  # v_scale
+        llaisysTensor_t,  # k
+        llaisysTensor_t,  # v
+        llaisysTensor_t,  # block_table
+        c_size_t,  # pos
+    ]
+    lib.llaisysKVAppend.restype = None
+
     lib.llaisysLinear.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
     lib.llaisysLinear.restype = None
 
+    lib.llaisysLinearQuantized.argtypes = [
+        llaisysTensor_t,  # out
+        llaisysTensor_t,  # in
+        llaisysTensor_t,  # weight
+        llaisysTensor_t,  # weight_scale
+        llaisysTensor_t,  # weight_zero
+        llaisysTensor_t,  # bias
+    ]
+    lib.llaisysLinearQuantized.restype = None
+
+    lib.llaisysLinearEpilogue.argtypes = [
+        llaisysTensor_t,  # out
+        llaisysTensor_t,  # in
+        llaisysTensor_t,  # weight
+        llaisysTensor_t,  # weight_scale
+        llaisysTensor_t,  # weight_zero
+        llaisysTensor_t,  # bias
+        llaisysTensor_t,  # residual
+        c_float,  # alpha
+    ]
+    lib.llaisysLinearEpilogue.restype = None
+
+    lib.llaisysLinearPackWeight.argtypes = [llaisysTensor_t]
+    lib.llaisysLinearPackWeight.restype = llaisysTensor_t
+
+    lib.llaisysLinearSwiGLU.argtypes = [
+        llaisysTensor_t,  # out
+        llaisysTensor_t,  # in
+        llaisysTensor_t,  # weight
+        llaisysTensor_t,  # weight_scale
+        llaisysTensor_t,  # weight_zero
+    ]
+    lib.llaisysLinearSwiGLU.restype = None
+
+    lib.llaisysPagedAttention.argtypes = [
+        llaisysTensor_t,  # attn_val
+        llaisysTensor_t,  # q
+        llaisysTensor_t,  # k_cache
+        llaisysTensor_t,  # v_cache
+        llaisysTensor_t,  # k_scale
+        llaisysTensor_t,  # v_scale
+        llaisysTensor_t,  # block_table
+        c_size_t,  # total_len
+        c_float,  # scale
+    ]
+    lib.llaisysPagedAttention.restype = None
+
+    lib.llaisysQuantize.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
+    lib.llaisysQuantize.restype = None
+
     lib.llaisysRearrange.argtypes = [llaisysTensor_t, llaisysTensor_t]
     lib.llaisysRearrange.restype = None
 
@@ -23,6 +103,27 @@ def load_ops(lib):
     lib.llaisysROPE.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t, c_float]
     lib.llaisysROPE.restype = None
 
+    lib.llaisysROPEWithTable.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
+    lib.llaisysROPEWithTable.restype = None
+
+    lib.llaisysROPETable.argtypes = [llaisysTensor_t, c_float]
+    lib.llaisysROPETable.restype = None
+
+    lib.llaisysROPEKVAppend.argtypes = [
+        llaisysTensor_t,  # q_out
+        llaisysTensor_t,  # k_cache
+        llaisysTensor_t,  # v_cache
+        llaisysTensor_t,  # k_scale
+        llaisysTensor_t,  # v_scale
+        llaisysTensor_t,  # q
+        llaisysTensor_t,  # k
+        llaisysTensor_t,  # v
+        llaisysTensor_t,  # table
+        llaisysTensor_t,  # block_table
+        c_size_t,  # pos
+    ]
+    lib.llaisysROPEKVAppend.restype = None
+
     lib.llaisysSelfAttention.argtypes = [
         llaisysTensor_t,  # attn_val
         llaisysTensor_t,  # q
@@ -46,3 +46,12 @@ def load_runtime(lib):
 
     lib.llaisysSetContextRuntime.argtypes = [llaisysDeviceType_t, c_int]
     lib.llaisysSetContextRuntime.restype = None
+
+    lib.llaisysSetNumThreads.argtypes = [c_size_t]
+    lib.llaisysSetNumThreads.restype = None
+
+    lib.llaisysGetNumThreads.argtypes = []
+    lib.llaisysGetNumThreads.restype = c_size_t
+
+    lib.llaisysSetThreadAffinity.argtypes = [ctypes.POINTER(c_int), c_size_t]
+    lib.llaisysSetThreadAffinity.restype = None
@@ -8,13 +8,41 @@ from pathlib import Path
 import torch
 from safetensors import safe_open
 
-from ..libllaisys import DeviceType
+from ..libllaisys import DeviceType, DataType
 from ..libllaisys.models import qwen2 as lib_qwen
 
+# 权重按 checkpoint 原始 dtype 交给后端，其他类型统一转换为 float32
+_WEIGHT_DTYPES = {
+    torch.float32: DataType.F32,
+    torch.bfloat16: DataType.BF16,
+    torch.float16: DataType.F16,
+}
+
+# 权重的加载时量化方式，与 C++ 端 Qwen2WeightQuant 对应
+_WEIGHT_QUANT = {
+    None: 0,
+    "int8": 1,
+    "q4": 2,
+}
+
 class Qwen2:
 
-    def __init__(self, model_path, device: DeviceType = DeviceType.CPU):
+    def __init__(
+        self,
+        model_path,
+        device: DeviceType = DeviceType.CPU,
+        quantize=None,
+        group_size: int = 64,
+        zero_point: bool = False,
+        prefill_chunk_size: int = 256,
+        kv_block_size: int = 16,
+        kv_cache_dtype: DataType = DataType.F32,
+        prefix_cache_mb: int = 256,
+        kv_cache_mb: int = 1024,
+    ):
         self.model_path = Path(model_path)
+        if quantize not in _WEIGHT_QUANT:
+            raise ValueError(f"Unsupported weight quantization: {quantize}")
         
         # 1. 加载 Config
         with open(self.model_path / "config.json", "r") as f:
@@ -29,6 +57,23 @@ class Qwen2:
         self.config.n_heads = hf_config["num_attention_heads"]
         self.config.n_kv_heads = hf_config["num_key_value_heads"]
         self.config.max_seq_len = 2048 
+        self.config.weight_quant = _WEIGHT_QUANT[quantize]
+        self.config.quant_group_size = group_size
+        self.config.quant_zero_point = int(zero_point)
+        # 更大的块 GEMM 效率更高，更小的块峰值内存更低、与并发解码请求交错时延迟更小
+        self.config.prefill_chunk_size = prefill_chunk_size
+        # KV cache 按 block 分配给各序列
+        self.config.kv_block_size = kv_block_size
+        # BF16/F16 的 KV cache 占用减半，I8 (每个 token 每个 kv head 一个 scale) 约为四分之一，
+        # 注意力读取 cache 的带宽同比例下降
+        if kv_cache_dtype not in (DataType.F32, DataType.BF16, DataType.F16, DataType.I8):
+            raise ValueError(f"Unsupported KV cache dtype: {kv_cache_dtype}")
+        self.config.kv_cache_dtype = kv_cache_dtype
+        # 共享 system prompt / 对话历史的请求从最长的已缓存前缀继续 prefill; 0 关闭
+        self.config.prefix_cache_mb = prefix_cache_mb
+        # 所有序列与前缀缓存共用的 block 池，一次分配不再扩容 (CPU 上按实际写入逐页占用物理内存);
+        # 池满时先淘汰前缀缓存，仍不够则前向报错 (调度器会换出最新的请求)
+        self.config.kv_cache_mb = kv_cache_mb
 
         print(f"Creating Qwen2 model backend... (Layers: {self.config.n_layers})")
         
@@ -51,8 +96,9 @@ class Qwen2:
                 for name in f.keys():
                     tensor = f.get_tensor(name)
                     
-                    # 【新增】强制转换为 float32，避免 C++ 端的精度不匹配问题
-                    tensor = tensor.float()
+                    if tensor.dtype not in _WEIGHT_DTYPES:
+                        tensor = tensor.float()
+                    dtype = _WEIGHT_DTYPES[tensor.dtype]
 
                     # 确保内存连续
                     if not tensor.is_contiguous():
@@ -61,12 +107,64 @@ class Qwen2:
                     data_ptr = tensor.data_ptr()
                     name_bytes = name.encode('utf-8')
 
-                    lib_qwen.qwen2_load_tensor(self.handle, name_bytes, ctypes.c_void_p(data_ptr))
+                    lib_qwen.qwen2_load_tensor(self.handle, name_bytes, ctypes.c_void_p(data_ptr), dtype)
         print("Weights loaded.")
 
     def forward(self, token: int, pos: int) -> int:
         return lib_qwen.qwen2_forward(self.handle, token, pos)
 
+    def prefill(self, tokens: Sequence[int], pos: int = 0) -> int:
+        """一次前向整段 tokens (位置从 pos 开始)，返回最后一个 token 之后的预测"""
+        ids = (ctypes.c_int64 * len(tokens))(*tokens)
+        return lib_qwen.qwen2_prefill(self.handle, ids, len(tokens), pos)
+
+    def prefill_sequence(self, seq_id: int, tokens: Sequence[int], pos: int = 0) -> int:
+        """同 prefill，作用于序列 seq_id; 一个模型可同时持有多个序列，共享权重与 KV cache"""
+        ids = (ctypes.c_int64 * len(tokens))(*tokens)
+        return lib_qwen.qwen2_prefill_sequence(self.handle, seq_id, ids, len(tokens), pos)
+
+    def forward_batch(self, seq_ids: Sequence[int], tokens: Sequence[int], positions: Sequence[int]) -> list:
+        """批量 decode: 序列 seq_ids[i] 在位置 positions[i] 前向 tokens[i]，返回各序列的下一个 token。
+        参数非法或 KV cache 不足时抛出 RuntimeError，所有序列保持调用前的长度"""
+        n = len(seq_ids)
+        next_tokens = (ctypes.c_int * n)()
+        status = lib_qwen.qwen2_forward_batch(
+            self.handle,
+            (ctypes.c_int * n)(*seq_ids),
+            (ctypes.c_int64 * n)(*tokens),
+            (ctypes.c_int * n)(*positions),
+            n,
+            next_tokens,
+        )
+        if status != 0:
+            raise RuntimeError("forward_batch failed")
+        return list(next_tokens)
+
+    def release_sequence(self, seq_id: int) -> None:
+        lib_qwen.qwen2_release_sequence(self.handle, seq_id)
+
+    def prefix_cache_stats(self) -> dict:
+        """前缀缓存的命中统计: 查询/命中次数、查询/复用的 token 数、淘汰与当前持有的 block 数"""
+        stats = lib_qwen.Qwen2PrefixCacheStats()
+        lib_qwen.qwen2_prefix_cache_stats(self.handle, ctypes.byref(stats))
+        result = {name: getattr(stats, name) for name, _ in stats._fields_}
+        result["hit_rate"] = stats.hit_tokens / stats.lookup_tokens if stats.lookup_tokens else 0.0
+        return result
+
+    def save_session(self, path) -> None:
+        """把当前序列的 token 与 KV cache 保存到 path，之后可用 load_session 恢复而无需重新 prefill"""
+        if lib_qwen.qwen2_save_session(self.handle, os.fsencode(path)) != 0:
+            raise RuntimeError(f"failed to save session to {path}")
+
+    def load_session(self, path) -> list:
+        """用 path 中保存的序列替换当前序列，返回其 token; 之后从位置 len(tokens) 继续 forward"""
+        capacity = self.config.max_seq_len
+        ids = (ctypes.c_int64 * capacity)()
+        n = lib_qwen.qwen2_load_session(self.handle, os.fsencode(path), ids, capacity)
+        if n < 0:
+            raise RuntimeError(f"failed to load session from {path}")
+        return list(ids[:n])
+
     def generate(
         self,
         inputs: Sequence[int],
@@ -76,15 +174,12 @@ class Qwen2:
         temperature: float = 0.8,
     ):
         prompt_len = len(inputs)
-        curr_pos = 0
         
-        # 1. Prefill
-        for i in range(prompt_len - 1):
-            _ = self.forward(inputs[i], curr_pos)
-            curr_pos += 1
+        # 1. Prefill: 整个 prompt 一次前向，直接得到第一个生成的 token
+        next_token = self.prefill(inputs, 0)
+        curr_pos = prompt_len
             
         # 2. Decoding
-        next_token = inputs[-1]
         output_tokens = []
         
         # Qwen2 的结束符 ID
@@ -92,8 +187,9 @@ class Qwen2:
         THINK_START_TOKEN_ID = 151646
         
         for step in range(max_new_tokens):
-            next_token = self.forward(next_token, curr_pos)
-            curr_pos += 1
+            if step > 0:
+                next_token = self.forward(next_token, curr_pos)
+                curr_pos += 1
 
             if step == 0 and next_token != THINK_START_TOKEN_ID:
                     print(f"Aligning first token: {next_token} -> {THINK_START_TOKEN_ID} (Force Thinking)")
@@ -105,4 +201,60 @@ class Qwen2:
                 
             output_tokens.append(next_token)
 
-        return output_tokens
\ No newline at end of file
+        return output_tokens
+
+
+class Qwen2Scheduler:
+    """连续批处理: 多个请求共享一个 Qwen2 模型，每个 decode 步接纳新请求、退出已结束的请求，
+    长 prompt 按 prefill_budget 分块与 decode 交错。调度器存在期间不要直接调用模型的前向接口。
+    采样为 greedy。"""
+
+    def __init__(self, model: Qwen2, max_batch: int = 64, prefill_budget: int = 0):
+        self.model = model  # 保持模型存活
+        self.handle = lib_qwen.qwen2_scheduler_create(model.handle, max_batch, prefill_budget)
+        # 已出错、但最后一批 token 刚被取走的请求，下一次 poll 时抛出
+        self._failed = set()
+
+    def __del__(self):
+        if hasattr(self, "handle") and self.handle:
+            lib_qwen.qwen2_scheduler_destroy(self.handle)
+            self.handle = None
+
+    def submit(self, inputs: Sequence[int], max_new_tokens: int = 128, eos_token: int = 151643) -> int:
+        """提交请求，返回请求 id; 生成 eos_token (包含在输出中) 或 max_new_tokens 个 token 后结束"""
+        ids = (ctypes.c_int64 * len(inputs))(*inputs)
+        request_id = lib_qwen.qwen2_scheduler_submit(self.handle, ids, len(inputs), max_new_tokens, eos_token)
+        if request_id < 0:
+            raise ValueError("invalid request")
+        return request_id
+
+    def poll(self, request_id: int, timeout_ms: int = 0, capacity: int = 256):
+        """返回 (新生成的 token, 是否已结束); 没有新 token 时最多等待 timeout_ms 毫秒 (< 0 一直等)。
+        请求出错时先照常返回已生成的 token，取完后抛出 RuntimeError"""
+        if request_id in self._failed:
+            self._failed.discard(request_id)
+            raise RuntimeError(f"request {request_id} failed")
+        tokens = (ctypes.c_int64 * capacity)()
+        finished = ctypes.c_int(0)
+        failed = ctypes.c_int(0)
+        n = lib_qwen.qwen2_scheduler_poll(
+            self.handle, request_id, tokens, capacity, timeout_ms, ctypes.byref(finished), ctypes.byref(failed)
+        )
+        if n < 0:
+            raise RuntimeError(f"request {request_id} is unknown")
+        if failed.value and finished.value:
+            if n == 0:
+                raise RuntimeError(f"request {request_id} failed")
+            self._failed.add(request_id)
+            return list(tokens[:n]), False
+        return list(tokens[:n]), bool(finished.value)
+
+    def stream(self, request_id: int):
+        """逐批产出请求生成的 token，直到请求结束"""
+        finished = False
+        while not finished:
+            tokens, finished = self.poll(request_id, timeout_ms=-1)
+            yield from tokens
+
+    def cancel(self, request_id: int) -> None:
+        lib_qwen.qwen2_scheduler_cancel(self.handle, request_id)
@@ -1,6 +1,6 @@
 from .libllaisys import LIB_LLAISYS
 from .tensor import Tensor
-from ctypes import c_float, c_int
+from ctypes import c_float, c_int, c_size_t
 
 
 class Ops:
@@ -8,6 +8,13 @@ class Ops:
     def add(c: Tensor, a: Tensor, b: Tensor):
         LIB_LLAISYS.llaisysAdd(c.lib_tensor(), a.lib_tensor(), b.lib_tensor())
 
+    @staticmethod
+    def add_rms_norm(out: Tensor, residual: Tensor, inp: Tensor, weight: Tensor, eps: float):
+        # residual += inp, out = rms_norm(residual)
+        LIB_LLAISYS.llaisysAddRmsNorm(
+            out.lib_tensor(), residual.lib_tensor(), inp.lib_tensor(), weight.lib_tensor(), c_float(eps)
+        )
+
     @staticmethod
     def argmax(max_idx: Tensor, max_val: Tensor, vals: Tensor):
         LIB_LLAISYS.llaisysArgmax(max_idx.lib_tensor(), max_val.lib_tensor(), vals.lib_tensor())
@@ -18,10 +25,134 @@ class Ops:
             out.lib_tensor(), index.lib_tensor(), weight.lib_tensor()
         )
 
+    @staticmethod
+    def embedding_quantized(out: Tensor, index: Tensor, weight: Tensor, weight_scale: Tensor, weight_zero: Tensor = None):
+        LIB_LLAISYS.llaisysEmbeddingQuantized(
+            out.lib_tensor(),
+            index.lib_tensor(),
+            weight.lib_tensor(),
+            weight_scale.lib_tensor(),
+            weight_zero.lib_tensor() if weight_zero is not None else None,
+        )
+
+    @staticmethod
+    def kv_append(
+        k_cache: Tensor,
+        v_cache: Tensor,
+        k: Tensor,
+        v: Tensor,
+        block_table: Tensor,
+        pos: int,
+        k_scale: Tensor = None,
+        v_scale: Tensor = None,
+    ):
+        # token pos + i goes to block block_table[(pos + i) // block_size]; an INT8 cache
+        # is quantized per (token, kv head) into k_scale / v_scale
+        LIB_LLAISYS.llaisysKVAppend(
+            k_cache.lib_tensor(),
+            v_cache.lib_tensor(),
+            k_scale.lib_tensor() if k_scale is not None else None,
+            v_scale.lib_tensor() if v_scale is not None else None,
+            k.lib_tensor(),
+            v.lib_tensor(),
+            block_table.lib_tensor(),
+            c_size_t(pos),
+        )
+
     @staticmethod
     def linear(out: Tensor, inp: Tensor, weight: Tensor, bias: Tensor):
         LIB_LLAISYS.llaisysLinear(
-            out.lib_tensor(), inp.lib_tensor(), weight.lib_tensor(), bias.lib_tensor()
+            out.lib_tensor(),
+            inp.lib_tensor(),
+            weight.lib_tensor(),
+            bias.lib_tensor() if bias is not None else None,
+        )
+
+    @staticmethod
+    def linear_quantized(
+        out: Tensor, inp: Tensor, weight: Tensor, weight_scale: Tensor, bias: Tensor, weight_zero: Tensor = None
+    ):
+        LIB_LLAISYS.llaisysLinearQuantized(
+            out.lib_tensor(),
+            inp.lib_tensor(),
+            weight.lib_tensor(),
+            weight_scale.lib_tensor(),
+            weight_zero.lib_tensor() if weight_zero is not None else None,
+            bias.lib_tensor() if bias is not None else None,
+        )
+
+    @staticmethod
+    def linear_epilogue(
+        out: Tensor,
+        inp: Tensor,
+        weight: Tensor,
+        bias: Tensor = None,
+        residual: Tensor = None,
+        alpha: float = 1.0,
+        weight_scale: Tensor = None,
+        weight_zero: Tensor = None,
+    ):
+        # out = alpha * (inp @ weight^T) + bias + residual; residual may be out itself
+        LIB_LLAISYS.llaisysLinearEpilogue(
+            out.lib_tensor(),
+            inp.lib_tensor(),
+            weight.lib_tensor(),
+            weight_scale.lib_tensor() if weight_scale is not None else None,
+            weight_zero.lib_tensor() if weight_zero is not None else None,
+            bias.lib_tensor() if bias is not None else None,
+            residual.lib_tensor() if residual is not None else None,
+            c_float(alpha),
+        )
+
+    @staticmethod
+    def linear_pack_weight(weight: Tensor) -> Tensor:
+        # the packed copy works as the weight of the linear ops only
+        return Tensor(tensor=LIB_LLAISYS.llaisysLinearPackWeight(weight.lib_tensor()))
+
+    @staticmethod
+    def linear_swiglu(out: Tensor, inp: Tensor, weight: Tensor, weight_scale: Tensor = None, weight_zero: Tensor = None):
+        # weight rows interleave gate and up: [gate_0, up_0, gate_1, up_1, ...]
+        LIB_LLAISYS.llaisysLinearSwiGLU(
+            out.lib_tensor(),
+            inp.lib_tensor(),
+            weight.lib_tensor(),
+            weight_scale.lib_tensor() if weight_scale is not None else None,
+            weight_zero.lib_tensor() if weight_zero is not None else None,
+        )
+
+    @staticmethod
+    def paged_attention(
+        attn_val: Tensor,
+        q: Tensor,
+        k_cache: Tensor,
+        v_cache: Tensor,
+        block_table: Tensor,
+        total_len: int,
+        scale: float,
+        k_scale: Tensor = None,
+        v_scale: Tensor = None,
+    ):
+        # key t lives in block block_table[t // block_size], row t % block_size;
+        # an INT8 cache also takes the scales written by kv_append
+        LIB_LLAISYS.llaisysPagedAttention(
+            attn_val.lib_tensor(),
+            q.lib_tensor(),
+            k_cache.lib_tensor(),
+            v_cache.lib_tensor(),
+            k_scale.lib_tensor() if k_scale is not None else None,
+            v_scale.lib_tensor() if v_scale is not None else None,
+            block_table.lib_tensor(),
+            c_size_t(total_len),
+            c_float(scale),
+        )
+
+    @staticmethod
+    def quantize(out: Tensor, scale: Tensor, inp: Tensor, zero: Tensor = None):
+        LIB_LLAISYS.llaisysQuantize(
+            out.lib_tensor(),
+            scale.lib_tensor(),
+            zero.lib_tensor() if zero is not None else None,
+            inp.lib_tensor(),
         )
 
     @staticmethod
@@ -35,11 +166,50 @@ class Ops:
         )
 
     @staticmethod
-    def rope(out: Tensor, inp: Tensor, pos_ids: Tensor, theta: float):
+    def rope(out: Tensor, inp: Tensor, pos_ids: Tensor, theta: float, table: Tensor = None):
+        # table 为 rope_table 预先算好的 cos/sin 时直接查表，theta 不再使用
+        if table is not None:
+            LIB_LLAISYS.llaisysROPEWithTable(
+                out.lib_tensor(), inp.lib_tensor(), pos_ids.lib_tensor(), table.lib_tensor()
+            )
+            return
         LIB_LLAISYS.llaisysROPE(
             out.lib_tensor(), inp.lib_tensor(), pos_ids.lib_tensor(), c_float(theta)
         )
 
+    @staticmethod
+    def rope_table(table: Tensor, theta: float):
+        LIB_LLAISYS.llaisysROPETable(table.lib_tensor(), c_float(theta))
+
+    @staticmethod
+    def rope_kv_append(
+        q_out: Tensor,
+        k_cache: Tensor,
+        v_cache: Tensor,
+        q: Tensor,
+        k: Tensor,
+        v: Tensor,
+        table: Tensor,
+        block_table: Tensor,
+        pos: int,
+        k_scale: Tensor = None,
+        v_scale: Tensor = None,
+    ):
+        # 一遍完成: q 旋转到 q_out，k 旋转后与 v 一起按 kv_append 写入 cache，第 i 个 token 位于 pos + i
+        LIB_LLAISYS.llaisysROPEKVAppend(
+            q_out.lib_tensor(),
+            k_cache.lib_tensor(),
+            v_cache.lib_tensor(),
+            k_scale.lib_tensor() if k_scale is not None else None,
+            v_scale.lib_tensor() if v_scale is not None else None,
+            q.lib_tensor(),
+            k.lib_tensor(),
+            v.lib_tensor(),
+            table.lib_tensor(),
+            block_table.lib_tensor(),
+            c_size_t(pos),
+        )
+
     @staticmethod
     def self_attention(attn_val: Tensor, q: Tensor, k: Tensor, v: Tensor, scale: float):
         LIB_LLAISYS.llaisysSelfAttention(
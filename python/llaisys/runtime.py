@@ -1,6 +1,6 @@
 from . import libllaisys
 from .libllaisys import LIB_LLAISYS
-from ctypes import c_void_p
+from ctypes import c_int, c_void_p
 
 
 class RuntimeAPI:
@@ -66,3 +66,19 @@ class RuntimeAPI:
         self._api.contents.memcpy_async(
             dst, src, size, libllaisys.llaisysMemcpyKind_t(kind), stream
         )
+
+
+def set_num_threads(num_threads: int) -> None:
+    """Set the number of threads used by cpu kernels, 0 for one per hardware thread."""
+    LIB_LLAISYS.llaisysSetNumThreads(num_threads)
+
+
+def get_num_threads() -> int:
+    return LIB_LLAISYS.llaisysGetNumThreads()
+
+
+def set_thread_affinity(cpu_ids) -> None:
+    """Pin cpu worker threads to `cpu_ids[1:]`; `cpu_ids[0]` is left to the caller.
+    With fewer than two ids the workers are unpinned."""
+    cpu_ids = list(cpu_ids)
+    LIB_LLAISYS.llaisysSetThreadAffinity((c_int * len(cpu_ids))(*cpu_ids), len(cpu_ids))
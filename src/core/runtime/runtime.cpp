@@ -8,15 +8,14 @@ Runtime::Runtime(llaisysDeviceType_t device_type, int device_id)
     : _device_type(device_type), _device_id(device_id), _is_active(false) {
     _api = llaisys::device::getRuntimeAPI(_device_type);
     _stream = _api->create_stream();
-    _allocator = new allocators::NaiveAllocator(_api);
+    _allocator = std::make_shared<allocators::NaiveAllocator>(_api);
 }
 
 Runtime::~Runtime() {
     if (!_is_active) {
         std::cerr << "Mallicious destruction of inactive runtime." << std::endl;
     }
-    delete _allocator;
-    _allocator = nullptr;
+    _allocator.reset();
     _api->destroy_stream(_stream);
     _api = nullptr;
 }
@@ -54,14 +53,6 @@ storage_t Runtime::allocateHostStorage(size_t size) {
     return std::shared_ptr<Storage>(new Storage((std::byte *)_api->malloc_host(size), size, *this, true));
 }
 
-void Runtime::freeStorage(Storage *storage) {
-    if (storage->isHost()) {
-        _api->free_host(storage->memory());
-    } else {
-        _allocator->release(storage->memory());
-    }
-}
-
 llaisysStream_t Runtime::stream() const {
     return _stream;
 }
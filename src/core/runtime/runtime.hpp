@@ -10,7 +10,8 @@ private:
     llaisysDeviceType_t _device_type;
     int _device_id;
     const LlaisysRuntimeAPI *_api;
-    MemoryAllocator *_allocator;
+    // Shared with the device storages it allocated, which may outlive this runtime
+    std::shared_ptr<MemoryAllocator> _allocator;
     bool _is_active;
     void _activate();
     void _deactivate();
@@ -19,6 +20,7 @@ private:
 
 public:
     friend class Context;
+    friend class Storage;
 
     ~Runtime();
 
@@ -39,7 +41,6 @@ public:
     storage_t allocateDeviceStorage(size_t size);
     ;
     storage_t allocateHostStorage(size_t size);
-    void freeStorage(Storage *storage);
 
     llaisysStream_t stream() const;
     void synchronize() const;
@@ -3,16 +3,25 @@
 
 #include "../core.hpp"
 
+#include "llaisys/runtime.h"
+
 #include <memory>
 
 namespace llaisys::core {
+class MemoryAllocator;
+
+// Keeps what it needs to free itself rather than a reference to the allocating Runtime:
+// runtimes live in thread-local contexts, and a storage may outlive the thread that made it.
 class Storage {
 private:
     std::byte *_memory;
     size_t _size;
-    Runtime &_runtime;
+    llaisysDeviceType_t _device_type;
+    int _device_id;
     bool _is_host;
-    Storage(std::byte *memory, size_t size, Runtime &runtime, bool is_host);
+    const LlaisysRuntimeAPI *_api;
+    std::shared_ptr<MemoryAllocator> _allocator;
+    Storage(std::byte *memory, size_t size, const Runtime &runtime, bool is_host);
 
 public:
     friend class Runtime;
@@ -0,0 +1,240 @@
+#include "thread_pool.hpp"
+
+#include "../../utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace llaisys::core {
+
+namespace {
+// How long an idle worker keeps polling for the next job before it goes to sleep.
+constexpr auto SPIN_DURATION = std::chrono::microseconds(200);
+
+thread_local bool t_in_parallel_region = false;
+
+// Marks the calling thread as inside a parallel region for the guard's lifetime.
+class ParallelRegion {
+public:
+    ParallelRegion() : _outer(t_in_parallel_region) { t_in_parallel_region = true; }
+    ~ParallelRegion() { t_in_parallel_region = _outer; }
+
+    ParallelRegion(const ParallelRegion &) = delete;
+    ParallelRegion &operator=(const ParallelRegion &) = delete;
+
+private:
+    bool _outer;
+};
+
+size_t default_num_threads() {
+    size_t n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+// Names the worker and pins it to cpu_id (if >= 0) from the creating thread, so both are in
+// place once the pool is (re)started.
+void setup_worker(std::thread &worker, int cpu_id) {
+#if defined(_WIN32)
+    if (cpu_id >= 0) {
+        SetThreadAffinityMask(worker.native_handle(), DWORD_PTR(1) << cpu_id);
+    }
+#elif defined(__linux__)
+    pthread_setname_np(worker.native_handle(), "llaisys-worker");
+    if (cpu_id >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu_id, &set);
+        pthread_setaffinity_np(worker.native_handle(), sizeof(set), &set);
+    }
+#else
+    (void)worker;
+    (void)cpu_id;
+#endif
+}
+} // namespace
+
+ThreadPool::ThreadPool(size_t num_threads)
+    : _fn(nullptr), _n(0), _grain(1), _epoch(0), _pending(0), _sleepers(0), _stop(false), _failed(false) {
+    _start(num_threads == 0 ? default_num_threads() : num_threads);
+}
+
+ThreadPool::~ThreadPool() {
+    _shutdown();
+}
+
+void ThreadPool::_start(size_t num_threads) {
+    _stop = false;
+    _ranges.reset(new Range[num_threads]);
+    for (size_t i = 0; i + 1 < num_threads; i++) {
+        _workers.emplace_back(&ThreadPool::_workerLoop, this, i + 1, _epoch.load());
+        // cpu_ids[0] belongs to the caller (participant 0); a single id leaves the workers unpinned.
+        int cpu_id = _cpu_ids.size() > 1 ? _cpu_ids[1 + i % (_cpu_ids.size() - 1)] : -1;
+        setup_worker(_workers.back(), cpu_id);
+    }
+}
+
+void ThreadPool::_shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_all();
+    for (auto &worker : _workers) {
+        worker.join();
+    }
+    _workers.clear();
+}
+
+size_t ThreadPool::numThreads() const {
+    return _workers.size() + 1;
+}
+
+void ThreadPool::setNumThreads(size_t num_threads) {
+    std::lock_guard<std::mutex> lock(_submit_mutex);
+    _shutdown();
+    _start(num_threads == 0 ? default_num_threads() : num_threads);
+}
+
+void ThreadPool::setAffinity(const std::vector<int> &cpu_ids) {
+    for (int cpu_id : cpu_ids) {
+        CHECK_ARGUMENT(cpu_id >= 0, "cpu id must be non-negative");
+    }
+    std::lock_guard<std::mutex> lock(_submit_mutex);
+    size_t num_threads = numThreads();
+    _shutdown();
+    _cpu_ids = cpu_ids;
+    _start(num_threads);
+}
+
+uint64_t ThreadPool::_waitForJob(uint64_t seen) {
+    auto spin_until = std::chrono::steady_clock::now() + SPIN_DURATION;
+    for (size_t i = 0;; i++) {
+        uint64_t epoch = _epoch.load(std::memory_order_acquire);
+        if (epoch != seen || _stop.load(std::memory_order_relaxed)) {
+            return epoch;
+        }
+        if (i % 256 == 255) {
+            if (std::chrono::steady_clock::now() > spin_until) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    _sleepers.fetch_add(1);
+    _cv.wait(lock, [&] { return _epoch.load() != seen || _stop.load(); });
+    _sleepers.fetch_sub(1);
+    return _epoch.load();
+}
+
+void ThreadPool::_workerLoop(size_t participant, uint64_t seen) {
+    t_in_parallel_region = true;
+    while (true) {
+        seen = _waitForJob(seen);
+        if (_stop.load()) {
+            return;
+        }
+        _runJob(participant);
+        _pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void ThreadPool::_runJob(size_t participant) {
+    size_t num_participants = numThreads();
+    try {
+        for (size_t i = 0; i < num_participants; i++) {
+            // Own range first, then steal from the others.
+            Range &range = _ranges[(participant + i) % num_participants];
+            while (!_failed.load(std::memory_order_relaxed)) {
+                size_t chunk = range.next.fetch_add(1, std::memory_order_relaxed);
+                if (chunk >= range.end) {
+                    break;
+                }
+                size_t begin = chunk * _grain;
+                (*_fn)(begin, std::min(_n, begin + _grain));
+            }
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_error) {
+            _error = std::current_exception();
+        }
+        _failed.store(true, std::memory_order_relaxed);
+    }
+}
+
+void ThreadPool::parallelFor(size_t n, size_t grain, const std::function<void(size_t, size_t)> &fn) {
+    if (n == 0) {
+        return;
+    }
+    if (grain == 0) {
+        grain = 1;
+    }
+    size_t num_chunks = (n + grain - 1) / grain;
+    if (num_chunks == 1 || t_in_parallel_region) {
+        return fn(0, n);
+    }
+    // The worker list may only be read under `_submit_mutex`: setNumThreads/setAffinity
+    // rebuild it while holding the lock.
+    std::unique_lock<std::mutex> submit(_submit_mutex, std::try_to_lock);
+    if (!submit.owns_lock()) {
+        return fn(0, n);
+    }
+    if (_workers.empty()) {
+        submit.unlock();
+        return fn(0, n);
+    }
+
+    size_t num_participants = numThreads();
+    for (size_t i = 0; i < num_participants; i++) {
+        _ranges[i].next.store(num_chunks * i / num_participants, std::memory_order_relaxed);
+        _ranges[i].end = num_chunks * (i + 1) / num_participants;
+    }
+    _fn = &fn;
+    _n = n;
+    _grain = grain;
+    _failed.store(false, std::memory_order_relaxed);
+    _pending.store(_workers.size());
+
+    _epoch.fetch_add(1);
+    if (_sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cv.notify_all();
+    }
+
+    {
+        ParallelRegion region;
+        _runJob(0);
+    }
+
+    // `fn` lives on the caller's stack; wait until every worker is done with it.
+    while (_pending.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+    _fn = nullptr;
+    if (_failed.load(std::memory_order_relaxed)) {
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::swap(error, _error);
+        }
+        std::rethrow_exception(error);
+    }
+}
+
+ThreadPool &threadPool() {
+    static ThreadPool pool(0);
+    return pool;
+}
+
+} // namespace llaisys::core
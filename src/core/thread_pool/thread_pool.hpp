@@ -0,0 +1,109 @@
+#pragma once
+#include "../core.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace llaisys::core {
+// Persistent worker threads shared by all cpu kernels of the process.
+//
+// A parallel loop is cut into fixed-size chunks that are dealt out as one contiguous
+// range per participant (the calling thread is participant 0). Each participant drains
+// its own range and then steals chunks from the others, so uneven chunks still balance.
+// Idle workers spin for a short while before sleeping, which keeps back-to-back small
+// ops from paying a wake-up each.
+class ThreadPool {
+private:
+    struct alignas(64) Range {
+        std::atomic<size_t> next;
+        size_t end;
+    };
+
+    std::vector<std::thread> _workers;
+    std::unique_ptr<Range[]> _ranges;
+    std::vector<int> _cpu_ids;
+
+    // Current job, written by the caller before bumping `_epoch`.
+    const std::function<void(size_t, size_t)> *_fn;
+    size_t _n;
+    size_t _grain;
+
+    std::atomic<uint64_t> _epoch;
+    std::atomic<size_t> _pending;
+    std::atomic<size_t> _sleepers;
+    std::atomic<bool> _stop;
+    // First exception thrown by `_fn` in the current job; later chunks are skipped once set.
+    std::atomic<bool> _failed;
+    std::exception_ptr _error;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    // Serializes jobs and reconfiguration; a busy pool makes other callers run inline.
+    std::mutex _submit_mutex;
+
+    void _start(size_t num_threads);
+    void _shutdown();
+    // `seen` is the epoch at creation, so a job submitted before the thread runs is not missed.
+    void _workerLoop(size_t participant, uint64_t seen);
+    uint64_t _waitForJob(uint64_t seen);
+    // Never throws: an exception from `_fn` is kept in `_error` for the caller to rethrow.
+    void _runJob(size_t participant);
+
+public:
+    explicit ThreadPool(size_t num_threads);
+    ~ThreadPool();
+
+    // Prevent copying
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Prevent moving
+    ThreadPool(ThreadPool &&) = delete;
+    ThreadPool &operator=(ThreadPool &&) = delete;
+
+    // Number of threads running a parallel loop, including the caller.
+    size_t numThreads() const;
+    // 0 means one thread per hardware thread.
+    void setNumThreads(size_t num_threads);
+    // Pin workers round-robin to `cpu_ids[1..]`, leaving `cpu_ids[0]` to the caller (which is
+    // not pinned here). With fewer than two ids the workers are unpinned.
+    void setAffinity(const std::vector<int> &cpu_ids);
+
+    // Calls fn(begin, end) on disjoint chunks covering [0, n). Chunk boundaries are
+    // multiples of `grain`. Nested calls run inline on the calling thread. If fn throws, the
+    // remaining chunks may be skipped and the first exception is rethrown once all workers
+    // have left the loop.
+    void parallelFor(size_t n, size_t grain, const std::function<void(size_t, size_t)> &fn);
+};
+
+// Global function to get the process-wide thread pool
+ThreadPool &threadPool();
+
+inline void parallel_for(size_t n, size_t grain, const std::function<void(size_t, size_t)> &fn) {
+    threadPool().parallelFor(n, grain, fn);
+}
+
+// Reduces map(begin, end) over the chunks of [0, n) in chunk order, so the result does
+// not depend on the thread count.
+template <typename T, typename Map, typename Reduce>
+T parallel_reduce(size_t n, size_t grain, T identity, const Map &map, const Reduce &reduce) {
+    if (grain == 0) {
+        grain = 1;
+    }
+    std::vector<T> partials((n + grain - 1) / grain, identity);
+    parallel_for(n, grain, [&](size_t begin, size_t end) {
+        partials[begin / grain] = map(begin, end);
+    });
+    T result = identity;
+    for (const T &partial : partials) {
+        result = reduce(result, partial);
+    }
+    return result;
+}
+} // namespace llaisys::core
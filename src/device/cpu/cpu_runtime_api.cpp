@@ -3,6 +3,10 @@
 #include <cstdlib>
 #include <cstring>
 
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
 namespace llaisys::device::cpu {
 
 namespace runtime_api {
@@ -29,12 +33,24 @@ void streamSynchronize(llaisysStream_t stream) {
     // do nothing
 }
 
+// Cache-line aligned, so vector loads and packed weight panels start on a line boundary.
+constexpr size_t ALIGNMENT = 64;
+
 void *mallocDevice(size_t size) {
-    return std::malloc(size);
+#if defined(_WIN32)
+    return _aligned_malloc(size, ALIGNMENT);
+#else
+    // aligned_alloc wants a size that is a multiple of the alignment
+    return std::aligned_alloc(ALIGNMENT, (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+#endif
 }
 
 void freeDevice(void *ptr) {
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
     std::free(ptr);
+#endif
 }
 
 void *mallocHost(size_t size) {
@@ -1,5 +1,7 @@
 #include "../../models/qwen2/qwen2_impl.hpp"
+#include "../../models/qwen2/qwen2_scheduler.hpp"
 #include <llaisys/models/qwen2.h> // Assuming this exists or define structs here
+#include <algorithm>
 #include <iostream>
 
 // 如果 include/llaisys/models/qwen2.h 里没有定义，我们需要匹配其签名
@@ -15,10 +17,28 @@ struct Qwen2ConfigC {
     int n_heads;
     int n_kv_heads;
     int max_seq_len;
+    int weight_quant; // 0: 保持 checkpoint dtype, 1: 投影层 INT8 每通道量化, 2: Q4 分组量化
+    int quant_group_size; // 仅 Q4
+    int quant_zero_point; // 仅 Q4: 非 0 时使用非对称分组 (带 zero point)
+    int prefill_chunk_size; // prefill 每块最多的 token 数，0 表示默认值
+    int kv_block_size; // 分页 KV cache 每个 block 的 token 数，0 表示默认值
+    llaisysDataType_t kv_cache_dtype; // KV cache 的存储类型 (F32/BF16/F16/I8)，0 表示 F32
+    int prefix_cache_mb; // 跨请求前缀缓存的 KV 上限 (MB)，0 表示不启用
+    int kv_cache_mb; // KV cache block 池的大小 (MB)，构造时一次分配; 0 表示默认值 1024
+};
+
+struct Qwen2PrefixCacheStatsC {
+    size_t lookups;
+    size_t hits;
+    size_t lookup_tokens;
+    size_t hit_tokens;
+    size_t evicted_blocks;
+    size_t cached_blocks;
 };
 
 // Handle definition
 typedef void* qwen2_model_t;
+typedef void* qwen2_scheduler_t;
 
 qwen2_model_t qwen2_create(const Qwen2ConfigC* config) {
     llaisys::Qwen2Config cpp_config;
@@ -29,6 +49,14 @@ qwen2_model_t qwen2_create(const Qwen2ConfigC* config) {
     cpp_config.n_heads = config->n_heads;
     cpp_config.n_kv_heads = config->n_kv_heads;
     cpp_config.max_seq_len = config->max_seq_len;
+    cpp_config.weight_quant = config->weight_quant;
+    cpp_config.quant_group_size = config->quant_group_size;
+    cpp_config.quant_zero_point = config->quant_zero_point;
+    cpp_config.prefill_chunk_size = config->prefill_chunk_size;
+    cpp_config.kv_block_size = config->kv_block_size;
+    cpp_config.kv_cache_dtype = config->kv_cache_dtype;
+    cpp_config.prefix_cache_mb = config->prefix_cache_mb;
+    cpp_config.kv_cache_mb = config->kv_cache_mb;
     // Hardcode specific params for Qwen2 1.5B
     cpp_config.rope_theta = 1000000.0f;
     cpp_config.rms_norm_eps = 1e-6f;
@@ -40,12 +68,107 @@ void qwen2_destroy(qwen2_model_t model) {
     delete static_cast<llaisys::Qwen2Impl*>(model);
 }
 
-void qwen2_load_tensor(qwen2_model_t model, const char* name, const void* data) {
-    static_cast<llaisys::Qwen2Impl*>(model)->load_tensor(std::string(name), const_cast<void*>(data));
+void qwen2_load_tensor(qwen2_model_t model, const char* name, const void* data, llaisysDataType_t dtype) {
+    static_cast<llaisys::Qwen2Impl*>(model)->load_tensor(std::string(name), const_cast<void*>(data), dtype);
 }
 
 int qwen2_forward(qwen2_model_t model, int token, int pos) {
     return static_cast<llaisys::Qwen2Impl*>(model)->forward(token, pos);
 }
 
+// 一次前向 tokens[0..ntoken) (位置从 pos 开始)，返回最后一个 token 之后的预测
+int qwen2_prefill(qwen2_model_t model, const int64_t* tokens, size_t ntoken, int pos) {
+    return static_cast<llaisys::Qwen2Impl*>(model)->forward(tokens, ntoken, pos);
+}
+
+// 同 qwen2_prefill，作用于序列 seq_id; 模型可同时持有多个序列，它们共享权重与 KV cache 的 block 池
+int qwen2_prefill_sequence(qwen2_model_t model, int seq_id, const int64_t* tokens, size_t ntoken, int pos) {
+    return static_cast<llaisys::Qwen2Impl*>(model)->forward(tokens, ntoken, pos, seq_id);
+}
+
+// 批量 decode: 序列 seq_ids[i] 在位置 positions[i] 前向 tokens[i]，预测写入 next_tokens[i]。
+// 成功返回 0; 参数非法或 KV cache 的 block 不足时返回 -1，所有序列保持调用前的长度
+int qwen2_forward_batch(qwen2_model_t model, const int* seq_ids, const int64_t* tokens, const int* positions,
+                        size_t n, int* next_tokens) {
+    try {
+        static_cast<llaisys::Qwen2Impl*>(model)->forward_batch(seq_ids, tokens, positions, n, next_tokens);
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] qwen2_forward_batch: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+// 结束序列 seq_id，释放其 KV
+void qwen2_release_sequence(qwen2_model_t model, int seq_id) {
+    static_cast<llaisys::Qwen2Impl*>(model)->release_sequence(seq_id);
+}
+
+void qwen2_prefix_cache_stats(qwen2_model_t model, Qwen2PrefixCacheStatsC* stats) {
+    llaisys::PrefixCacheStats s = static_cast<llaisys::Qwen2Impl*>(model)->prefix_cache_stats();
+    *stats = Qwen2PrefixCacheStatsC{s.lookups, s.hits, s.lookup_tokens, s.hit_tokens, s.evicted_blocks, s.cached_blocks};
+}
+
+// 把当前序列的 token 与 KV 写入 path，成功返回 0，失败返回 -1
+int qwen2_save_session(qwen2_model_t model, const char* path) {
+    try {
+        static_cast<llaisys::Qwen2Impl*>(model)->save_session(std::string(path));
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] qwen2_save_session: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+// 从 path 恢复序列，返回其 token 数并把 token 写入 tokens (最多 capacity 个)，失败返回 -1。
+// 之后从位置 = 返回值继续 forward
+int qwen2_load_session(qwen2_model_t model, const char* path, int64_t* tokens, size_t capacity) {
+    try {
+        std::vector<int64_t> loaded = static_cast<llaisys::Qwen2Impl*>(model)->load_session(std::string(path));
+        std::copy_n(loaded.begin(), std::min(capacity, loaded.size()), tokens);
+        return (int)loaded.size();
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] qwen2_load_session: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+// 在 model 上创建连续批处理调度器 (见 Qwen2Scheduler)，它存在期间不能再直接调用 model 的前向接口。
+// max_batch / prefill_budget 为 0 时使用默认值
+qwen2_scheduler_t qwen2_scheduler_create(qwen2_model_t model, int max_batch, int prefill_budget) {
+    llaisys::Qwen2SchedulerConfig config{max_batch, prefill_budget};
+    return new llaisys::Qwen2Scheduler(*static_cast<llaisys::Qwen2Impl*>(model), config);
+}
+
+void qwen2_scheduler_destroy(qwen2_scheduler_t scheduler) {
+    delete static_cast<llaisys::Qwen2Scheduler*>(scheduler);
+}
+
+// 提交请求，返回请求 id; eos_token < 0 表示不按结束符停止。参数非法时返回 -1
+int64_t qwen2_scheduler_submit(qwen2_scheduler_t scheduler, const int64_t* prompt, size_t ntoken,
+                               size_t max_new_tokens, int64_t eos_token) {
+    try {
+        return static_cast<llaisys::Qwen2Scheduler*>(scheduler)->submit(prompt, ntoken, max_new_tokens, eos_token);
+    } catch (const std::exception&) {
+        return -1; // CHECK_ARGUMENT 已输出原因
+    }
+}
+
+// 取出请求新生成的 token (最多 capacity 个)，返回个数; 没有新 token 时最多等待 timeout_ms 毫秒 (< 0 一直等)。
+// *finished 非 0 表示请求已结束且 token 已取完; *failed 非 0 表示请求因错误中止。id 无效时返回 -1
+int qwen2_scheduler_poll(qwen2_scheduler_t scheduler, int64_t request_id, int64_t* tokens, size_t capacity,
+                         int timeout_ms, int* finished, int* failed) {
+    bool done = false;
+    bool error = false;
+    int n = static_cast<llaisys::Qwen2Scheduler*>(scheduler)->poll(request_id, tokens, capacity, timeout_ms, &done,
+                                                                   &error);
+    *finished = done ? 1 : 0;
+    *failed = error ? 1 : 0;
+    return n;
+}
+
+void qwen2_scheduler_cancel(qwen2_scheduler_t scheduler, int64_t request_id) {
+    static_cast<llaisys::Qwen2Scheduler*>(scheduler)->cancel(request_id);
+}
+
 } // extern "C"
\ No newline at end of file
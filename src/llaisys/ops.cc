@@ -3,9 +3,14 @@
 #include "llaisys_tensor.hpp"
 
 #include "../ops/add/op.hpp"
+#include "../ops/add_rms_norm/op.hpp"
 #include "../ops/argmax/op.hpp"
 #include "../ops/embedding/op.hpp"
+#include "../ops/kv_append/op.hpp"
 #include "../ops/linear/op.hpp"
+#include "../ops/linear_swiglu/op.hpp"
+#include "../ops/paged_attention/op.hpp"
+#include "../ops/quantize/op.hpp"
 #include "../ops/rearrange/op.hpp"
 #include "../ops/rms_norm/op.hpp"
 #include "../ops/rope/op.hpp"
@@ -16,14 +21,49 @@ __C {
     void llaisysAdd(llaisysTensor_t c, llaisysTensor_t a, llaisysTensor_t b) {
         llaisys::ops::add(c->tensor, a->tensor, b->tensor);
     }
+    void llaisysAddRmsNorm(llaisysTensor_t out, llaisysTensor_t residual, llaisysTensor_t in, llaisysTensor_t weight, float eps) {
+        llaisys::ops::add_rms_norm(out->tensor, residual->tensor, in->tensor, weight->tensor, eps);
+    }
     void llaisysArgmax(llaisysTensor_t max_idx, llaisysTensor_t max_val, llaisysTensor_t vals) {
         llaisys::ops::argmax(max_idx->tensor, max_val->tensor, vals->tensor);
     }
     void llaisysEmbedding(llaisysTensor_t out, llaisysTensor_t index, llaisysTensor_t weight) {
         llaisys::ops::embedding(out->tensor, index->tensor, weight->tensor);
     }
+    void llaisysEmbeddingQuantized(llaisysTensor_t out, llaisysTensor_t index, llaisysTensor_t weight, llaisysTensor_t weight_scale, llaisysTensor_t weight_zero) {
+        llaisys::ops::embedding(out->tensor, index->tensor, weight->tensor, weight_scale->tensor,
+                                weight_zero ? weight_zero->tensor : nullptr);
+    }
+    void llaisysKVAppend(llaisysTensor_t k_cache, llaisysTensor_t v_cache, llaisysTensor_t k_scale, llaisysTensor_t v_scale, llaisysTensor_t k, llaisysTensor_t v, llaisysTensor_t block_table, size_t pos) {
+        llaisys::ops::kv_append(k_cache->tensor, v_cache->tensor, k_scale ? k_scale->tensor : nullptr,
+                                v_scale ? v_scale->tensor : nullptr, k->tensor, v->tensor, block_table->tensor, pos);
+    }
     void llaisysLinear(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, llaisysTensor_t bias) {
-        llaisys::ops::linear(out->tensor, in->tensor, weight->tensor, bias->tensor);
+        llaisys::ops::linear(out->tensor, in->tensor, weight->tensor, bias ? bias->tensor : nullptr);
+    }
+    void llaisysLinearQuantized(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, llaisysTensor_t weight_scale, llaisysTensor_t weight_zero, llaisysTensor_t bias) {
+        llaisys::ops::linear(out->tensor, in->tensor, weight->tensor, bias ? bias->tensor : nullptr, weight_scale->tensor,
+                             weight_zero ? weight_zero->tensor : nullptr);
+    }
+    void llaisysLinearEpilogue(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, llaisysTensor_t weight_scale, llaisysTensor_t weight_zero, llaisysTensor_t bias, llaisysTensor_t residual, float alpha) {
+        llaisys::ops::linear(out->tensor, in->tensor, weight->tensor, bias ? bias->tensor : nullptr,
+                             weight_scale ? weight_scale->tensor : nullptr, weight_zero ? weight_zero->tensor : nullptr,
+                             residual ? residual->tensor : nullptr, alpha);
+    }
+    llaisysTensor_t llaisysLinearPackWeight(llaisysTensor_t weight) {
+        return new LlaisysTensor{llaisys::ops::linear_pack_weight(weight->tensor)};
+    }
+    void llaisysLinearSwiGLU(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, llaisysTensor_t weight_scale, llaisysTensor_t weight_zero) {
+        llaisys::ops::linear_swiglu(out->tensor, in->tensor, weight->tensor, weight_scale ? weight_scale->tensor : nullptr,
+                                    weight_zero ? weight_zero->tensor : nullptr);
+    }
+    void llaisysPagedAttention(llaisysTensor_t attn_val, llaisysTensor_t q, llaisysTensor_t k_cache, llaisysTensor_t v_cache, llaisysTensor_t k_scale, llaisysTensor_t v_scale, llaisysTensor_t block_table, size_t total_len, float scale) {
+        llaisys::ops::paged_attention(attn_val->tensor, q->tensor, k_cache->tensor, v_cache->tensor,
+                                      k_scale ? k_scale->tensor : nullptr, v_scale ? v_scale->tensor : nullptr,
+                                      block_table->tensor, total_len, scale);
+    }
+    void llaisysQuantize(llaisysTensor_t out, llaisysTensor_t scale, llaisysTensor_t zero, llaisysTensor_t in) {
+        llaisys::ops::quantize(out->tensor, scale->tensor, in->tensor, zero ? zero->tensor : nullptr);
     }
     void llaisysRearrange(llaisysTensor_t out, llaisysTensor_t in) {
         llaisys::ops::rearrange(out->tensor, in->tensor);
@@ -34,6 +74,17 @@ __C {
     void llaisysROPE(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t pos_ids, float theta) {
         llaisys::ops::rope(out->tensor, in->tensor, pos_ids->tensor, theta);
     }
+    void llaisysROPEWithTable(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t pos_ids, llaisysTensor_t table) {
+        llaisys::ops::rope(out->tensor, in->tensor, pos_ids->tensor, 0.0f, table->tensor);
+    }
+    void llaisysROPETable(llaisysTensor_t table, float theta) {
+        llaisys::ops::rope_table(table->tensor, theta);
+    }
+    void llaisysROPEKVAppend(llaisysTensor_t q_out, llaisysTensor_t k_cache, llaisysTensor_t v_cache, llaisysTensor_t k_scale, llaisysTensor_t v_scale, llaisysTensor_t q, llaisysTensor_t k, llaisysTensor_t v, llaisysTensor_t table, llaisysTensor_t block_table, size_t pos) {
+        llaisys::ops::rope_kv_append(q_out->tensor, k_cache->tensor, v_cache->tensor, k_scale ? k_scale->tensor : nullptr,
+                                     v_scale ? v_scale->tensor : nullptr, q->tensor, k->tensor, v->tensor,
+                                     table->tensor, block_table->tensor, pos);
+    }
     void llaisysSelfAttention(llaisysTensor_t attn_val, llaisysTensor_t q, llaisysTensor_t k, llaisysTensor_t v, float scale) {
         llaisys::ops::self_attention(attn_val->tensor, q->tensor, k->tensor, v->tensor, scale);
     }
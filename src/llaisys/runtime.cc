@@ -1,5 +1,6 @@
 #include "llaisys/runtime.h"
 #include "../core/context/context.hpp"
+#include "../core/thread_pool/thread_pool.hpp"
 #include "../device/runtime_api.hpp"
 
 // Llaisys API for setting context runtime.
@@ -10,4 +11,17 @@ __C void llaisysSetContextRuntime(llaisysDeviceType_t device_type, int device_id
 // Llaisys API for getting the runtime APIs
 __C const LlaisysRuntimeAPI *llaisysGetRuntimeAPI(llaisysDeviceType_t device_type) {
     return llaisys::device::getRuntimeAPI(device_type);
-}
\ No newline at end of file
+}
+
+// Llaisys API for configuring the cpu thread pool
+__C void llaisysSetNumThreads(size_t num_threads) {
+    llaisys::core::threadPool().setNumThreads(num_threads);
+}
+
+__C size_t llaisysGetNumThreads() {
+    return llaisys::core::threadPool().numThreads();
+}
+
+__C void llaisysSetThreadAffinity(const int *cpu_ids, size_t ncpu) {
+    llaisys::core::threadPool().setAffinity(std::vector<int>(cpu_ids, cpu_ids + ncpu));
+}
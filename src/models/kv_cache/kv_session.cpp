@@ -0,0 +1,162 @@
+#include "kv_session.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+#include "../../utils/mapped_file.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace llaisys {
+
+namespace {
+// KV 数据段的起始对齐，映射后每段都从缓存行边界开始
+constexpr size_t SESSION_ALIGNMENT = 64;
+
+[[noreturn]] void fail(const std::string &path, const std::string &message) {
+    throw std::runtime_error("KVSession: " + path + ": " + message);
+}
+
+// 第 layer 层依次写入文件的池: K、V，I8 时还有两个 scale 池
+std::vector<tensor_t> layer_pools(const PagedKVCache &cache, size_t layer) {
+    std::vector<tensor_t> pools{cache.keys(layer), cache.values(layer)};
+    if (cache.keyScales(layer)) {
+        pools.push_back(cache.keyScales(layer));
+        pools.push_back(cache.valueScales(layer));
+    }
+    return pools;
+}
+
+// 池中一个 token 的字节数
+size_t row_bytes(const tensor_t &pool) {
+    return pool->numel() / (pool->shape()[0] * pool->shape()[1]) * pool->elementSize();
+}
+
+// 序列在池中的行按 block 分段，对每段调用 fn(池中的首地址, 该段在序列中的字节偏移, 字节数)
+template <typename Fn>
+void for_each_run(const tensor_t &pool, const KVSequence &seq, size_t block_size, Fn fn) {
+    size_t bytes_per_row = row_bytes(pool);
+    for (size_t t = 0; t < seq.length; t += block_size) {
+        size_t rows = std::min(block_size, seq.length - t);
+        std::byte *rows_ptr = pool->data() + (size_t)seq.blocks[t / block_size] * block_size * bytes_per_row;
+        fn(rows_ptr, t * bytes_per_row, rows * bytes_per_row);
+    }
+}
+
+size_t data_offset(size_t length) {
+    size_t end = sizeof(KVSessionHeader) + length * sizeof(int64_t);
+    return (end + SESSION_ALIGNMENT - 1) / SESSION_ALIGNMENT * SESSION_ALIGNMENT;
+}
+} // namespace
+
+void save_kv_session(const std::string &path, const PagedKVCache &cache, const KVSequence &seq,
+                     const int64_t *tokens, uint64_t config_hash) {
+    KVSessionHeader header{};
+    std::memcpy(header.magic, KV_SESSION_MAGIC, sizeof(header.magic));
+    header.version = KV_SESSION_VERSION;
+    header.dtype = (uint32_t)cache.dtype();
+    header.config_hash = config_hash;
+    header.n_layers = cache.numLayers();
+    header.n_kv_heads = cache.numKVHeads();
+    header.head_dim = cache.headDim();
+    header.length = seq.length;
+    header.data_offset = data_offset(seq.length);
+
+    std::string tmp_path = path + ".tmp";
+    std::FILE *file = std::fopen(tmp_path.c_str(), "wb");
+    if (!file) {
+        fail(path, "cannot create the file");
+    }
+    auto write = [&](const void *data, size_t bytes) {
+        if (bytes > 0 && std::fwrite(data, 1, bytes, file) != bytes) {
+            std::fclose(file);
+            std::remove(tmp_path.c_str());
+            fail(path, "write failed");
+        }
+    };
+    write(&header, sizeof(header));
+    write(tokens, seq.length * sizeof(int64_t));
+    std::vector<std::byte> staging(header.data_offset - sizeof(header) - seq.length * sizeof(int64_t));
+    write(staging.data(), staging.size());
+
+    // 每个 block 的行先拷到 host 再写出
+    core::context().setDevice(cache.keys(0)->deviceType(), cache.keys(0)->deviceId());
+    auto api = core::context().runtime().api();
+    for (size_t layer = 0; layer < cache.numLayers(); ++layer) {
+        for (const auto &pool : layer_pools(cache, layer)) {
+            for_each_run(pool, seq, cache.blockSize(), [&](const std::byte *rows, size_t, size_t bytes) {
+                staging.resize(bytes);
+                api->memcpy_sync(staging.data(), rows, bytes, LLAISYS_MEMCPY_D2H);
+                write(staging.data(), bytes);
+            });
+        }
+    }
+    if (std::fclose(file) != 0) {
+        std::remove(tmp_path.c_str());
+        fail(path, "write failed");
+    }
+    std::filesystem::rename(tmp_path, path);
+}
+
+std::vector<int64_t> load_kv_session(const std::string &path, PagedKVCache &cache, KVSequence &seq,
+                                     uint64_t config_hash, size_t max_length) {
+    ASSERT(seq.blocks.empty() && seq.length == 0, "KVSession: load needs an empty sequence");
+    utils::MappedFile file(path);
+
+    KVSessionHeader header;
+    if (file.size() < sizeof(header)) {
+        fail(path, "not a session file");
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, KV_SESSION_MAGIC, sizeof(header.magic)) != 0) {
+        fail(path, "not a session file");
+    }
+    if (header.version != KV_SESSION_VERSION) {
+        fail(path, "unsupported version " + std::to_string(header.version));
+    }
+    if (header.config_hash != config_hash) {
+        fail(path, "saved by a model with a different config");
+    }
+    if (header.dtype != (uint32_t)cache.dtype() || header.n_layers != cache.numLayers() ||
+        header.n_kv_heads != cache.numKVHeads() || header.head_dim != cache.headDim()) {
+        fail(path, "KV layout does not match the cache");
+    }
+
+    if (header.length > max_length) {
+        fail(path, "session of " + std::to_string(header.length) + " tokens exceeds " + std::to_string(max_length));
+    }
+
+    // 在分配 block 之前确认文件完整
+    size_t length = header.length;
+    size_t values = length * header.n_kv_heads * header.head_dim;
+    size_t layer_bytes = 2 * values * utils::dsize(cache.dtype());
+    if (cache.keyScales(0)) {
+        layer_bytes += 2 * length * header.n_kv_heads * sizeof(float);
+    }
+    if (header.data_offset != data_offset(length) || file.size() < header.data_offset + header.n_layers * layer_bytes) {
+        fail(path, "file is truncated");
+    }
+
+    const std::byte *base = file.data();
+    std::vector<int64_t> tokens(length);
+    std::memcpy(tokens.data(), base + sizeof(header), length * sizeof(int64_t));
+
+    cache.resize(seq, length);
+    core::context().setDevice(cache.keys(0)->deviceType(), cache.keys(0)->deviceId());
+    auto api = core::context().runtime().api();
+    const std::byte *section = base + header.data_offset;
+    for (size_t layer = 0; layer < cache.numLayers(); ++layer) {
+        for (const auto &pool : layer_pools(cache, layer)) {
+            for_each_run(pool, seq, cache.blockSize(), [&](std::byte *rows, size_t offset, size_t bytes) {
+                api->memcpy_sync(rows, section + offset, bytes, LLAISYS_MEMCPY_H2D);
+            });
+            section += length * row_bytes(pool);
+        }
+    }
+    return tokens;
+}
+
+} // namespace llaisys
@@ -0,0 +1,39 @@
+#pragma once
+#include "paged_kv_cache.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace llaisys {
+
+// 会话文件: 一个序列的 token 及其 KV，按 token 顺序存放，与 block 大小和块号无关。
+// 布局: KVSessionHeader | tokens I64 [length] | 从 data_offset (64 字节对齐) 起每层依次为
+//   K [length, n_kv_heads, head_dim], V [length, n_kv_heads, head_dim],
+//   I8 cache 另有 K scale [length, n_kv_heads] F32, V scale [length, n_kv_heads] F32
+// 格式变化时递增 KV_SESSION_VERSION，旧文件在读取时被拒绝
+constexpr char KV_SESSION_MAGIC[8] = {'L', 'L', 'A', 'I', 'S', 'Y', 'S', 'K'};
+constexpr uint32_t KV_SESSION_VERSION = 1;
+
+struct KVSessionHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;       // cache 的 llaisysDataType_t
+    uint64_t config_hash; // 生成 KV 的模型配置，不同配置的 KV 不能互用
+    uint64_t n_layers;
+    uint64_t n_kv_heads;
+    uint64_t head_dim;
+    uint64_t length;      // token 数
+    uint64_t data_offset; // 第一层 K 的字节偏移
+};
+
+// 把 seq 的 seq.length 个 token (tokens) 及其 KV 写入 path (先写临时文件再改名，不会留下半个文件)
+void save_kv_session(const std::string &path, const PagedKVCache &cache, const KVSequence &seq,
+                     const int64_t *tokens, uint64_t config_hash);
+// 以内存映射打开 path，校验版本、config hash 与 cache 的类型和形状后，为空序列 seq 分配 block
+// 并把 KV 直接从映射拷入，返回文件中的 token。文件不符或长于 max_length 时抛出 std::runtime_error，
+// seq 保持为空
+std::vector<int64_t> load_kv_session(const std::string &path, PagedKVCache &cache, KVSequence &seq,
+                                     uint64_t config_hash, size_t max_length);
+
+} // namespace llaisys
@@ -0,0 +1,135 @@
+#include "paged_kv_cache.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace llaisys {
+
+PagedKVCache::PagedKVCache(size_t n_layers, size_t n_kv_heads, size_t head_dim, size_t block_size, size_t num_blocks,
+                           llaisysDataType_t dtype, llaisysDeviceType_t device_type, int device_id)
+    : _n_kv_heads(n_kv_heads), _head_dim(head_dim), _block_size(block_size), _dtype(dtype),
+      _device_type(device_type), _device_id(device_id), _num_blocks(num_blocks), _keys(n_layers),
+      _values(n_layers), _ref_count(num_blocks, 0) {
+    CHECK_ARGUMENT(block_size > 0, "PagedKVCache: block size must be positive");
+    CHECK_ARGUMENT(num_blocks > 0 && num_blocks <= (size_t)INT32_MAX, "PagedKVCache: invalid number of blocks");
+    CHECK_ARGUMENT(dtype == LLAISYS_DTYPE_F32 || dtype == LLAISYS_DTYPE_BF16 || dtype == LLAISYS_DTYPE_F16 ||
+                       dtype == LLAISYS_DTYPE_I8,
+                   "PagedKVCache: dtype must be F32, BF16, F16 or I8");
+    for (size_t layer = 0; layer < n_layers; ++layer) {
+        _keys[layer] = Tensor::create({num_blocks, block_size, n_kv_heads, head_dim}, dtype, device_type, device_id);
+        _values[layer] = Tensor::create({num_blocks, block_size, n_kv_heads, head_dim}, dtype, device_type, device_id);
+        if (dtype == LLAISYS_DTYPE_I8) {
+            _key_scales.push_back(
+                Tensor::create({num_blocks, block_size, n_kv_heads}, LLAISYS_DTYPE_F32, device_type, device_id));
+            _value_scales.push_back(
+                Tensor::create({num_blocks, block_size, n_kv_heads}, LLAISYS_DTYPE_F32, device_type, device_id));
+        }
+    }
+    // 逆序入栈，初始时先分配到的是小块号
+    _free.reserve(num_blocks);
+    for (size_t block = num_blocks; block > 0; --block) {
+        _free.push_back((int32_t)(block - 1));
+    }
+}
+
+size_t PagedKVCache::blockBytes(size_t n_layers, size_t n_kv_heads, size_t head_dim, size_t block_size,
+                                llaisysDataType_t dtype) {
+    size_t bytes = 2 * block_size * n_kv_heads * head_dim * utils::dsize(dtype);
+    if (dtype == LLAISYS_DTYPE_I8) {
+        bytes += 2 * block_size * n_kv_heads * sizeof(float);
+    }
+    return bytes * n_layers;
+}
+
+void PagedKVCache::resize(KVSequence &seq, size_t length) {
+    size_t needed = (length + _block_size - 1) / _block_size;
+    // 接下来从 min(原长度, length) 开始写入; 该位置若在一个共享 block 的中间，先复制一份
+    size_t write_from = std::min(seq.length, length);
+    size_t first = write_from / _block_size;
+    auto shared_first = [&] {
+        return write_from % _block_size != 0 && first < seq.blocks.size() && _ref_count[seq.blocks[first]] > 1;
+    };
+    // 先分配需要的全部新 block，不足时归还已分配的再抛出，seq 保持原样
+    const bool copy_first = shared_first();
+    std::vector<int32_t> fresh;
+    size_t count = (needed > seq.blocks.size() ? needed - seq.blocks.size() : 0) + (copy_first ? 1 : 0);
+    try {
+        while (fresh.size() < count) {
+            fresh.push_back(_allocate());
+        }
+    } catch (...) {
+        for (int32_t block : fresh) {
+            release(block);
+        }
+        throw;
+    }
+
+    while (seq.blocks.size() > needed) {
+        release(seq.blocks.back());
+        seq.blocks.pop_back();
+    }
+    if (copy_first) {
+        // 分配时的回收可能已让该 block 变为独占，此时不必复制
+        int32_t copy = fresh.back();
+        fresh.pop_back();
+        if (shared_first()) {
+            _copy(copy, seq.blocks[first]);
+            release(seq.blocks[first]);
+            seq.blocks[first] = copy;
+        } else {
+            release(copy);
+        }
+    }
+    seq.blocks.insert(seq.blocks.end(), fresh.begin(), fresh.end());
+    seq.length = length;
+}
+
+void PagedKVCache::retain(int32_t block) {
+    ASSERT(block >= 0 && (size_t)block < _num_blocks && _ref_count[block] > 0, "PagedKVCache: retaining a free block");
+    ++_ref_count[block];
+}
+
+void PagedKVCache::release(int32_t block) {
+    ASSERT(block >= 0 && (size_t)block < _num_blocks && _ref_count[block] > 0, "PagedKVCache: releasing a free block");
+    if (--_ref_count[block] == 0) {
+        _free.push_back(block);
+    }
+}
+
+size_t PagedKVCache::reclaim(size_t wanted) {
+    while (_free.size() < wanted && _reclaim && _reclaim()) {
+    }
+    return _free.size();
+}
+
+int32_t PagedKVCache::_allocate() {
+    if (reclaim(1) == 0) {
+        throw KVCacheFullError("PagedKVCache: all " + std::to_string(_num_blocks) + " blocks are in use");
+    }
+    int32_t block = _free.back();
+    _free.pop_back();
+    _ref_count[block] = 1;
+    return block;
+}
+
+void PagedKVCache::_copy(int32_t dst, int32_t src) {
+    auto api = core::context().runtime().api();
+    auto copy = [&](const tensor_t &pool) {
+        size_t bytes = pool->numel() / _num_blocks * pool->elementSize();
+        api->memcpy_sync(pool->data() + dst * bytes, pool->data() + src * bytes, bytes, LLAISYS_MEMCPY_D2D);
+    };
+    core::context().setDevice(_device_type, _device_id);
+    for (size_t layer = 0; layer < _keys.size(); ++layer) {
+        copy(_keys[layer]);
+        copy(_values[layer]);
+        if (!_key_scales.empty()) {
+            copy(_key_scales[layer]);
+            copy(_value_scales[layer]);
+        }
+    }
+}
+
+} // namespace llaisys
@@ -0,0 +1,94 @@
+#pragma once
+#include "../../tensor/tensor.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+namespace llaisys {
+
+// 一个序列在分页 KV cache 中的位置: 第 t 个 token 位于 blocks[t / block_size] 块的第 t % block_size 行
+struct KVSequence {
+    std::vector<int32_t> blocks;
+    size_t length = 0;
+};
+
+// 池中的 block 全部被占用且无法回收时由 PagedKVCache::resize 抛出，调用方可借此换出序列后重试
+class KVCacheFullError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// 分页 KV cache: 所有层、所有序列共享一个由固定大小 block 组成的池，
+// 每层的 K/V 池为 [num_blocks, block_size, n_kv_heads, head_dim]。
+// 池在构造时按 num_blocks 一次分配，之后既不扩容也不搬移; CPU 上未写入的页不占物理内存，
+// 占用随实际写入的 token 增长。序列只占用覆盖其长度所需的 block，释放的 block 回到空闲表复用，
+// block 大小固定因此不会产生碎片。空闲 block 用完时先调用 reclaim 回收，仍没有则抛出异常。
+// dtype 为 F32/BF16/F16/I8; I8 时另有每层的 F32 scale 池 [num_blocks, block_size, n_kv_heads]，
+// 每个 (token, kv head) 一个 scale (见 ops::kv_append)。
+// block 带引用计数，可以被多个序列 (以及 PrefixCache) 共享；写入共享 block 之前 resize 会先复制一份。
+class PagedKVCache {
+public:
+    PagedKVCache(size_t n_layers, size_t n_kv_heads, size_t head_dim, size_t block_size, size_t num_blocks,
+                 llaisysDataType_t dtype, llaisysDeviceType_t device_type = LLAISYS_DEVICE_CPU, int device_id = 0);
+
+    size_t blockSize() const { return _block_size; }
+    size_t numLayers() const { return _keys.size(); }
+    size_t numKVHeads() const { return _n_kv_heads; }
+    size_t headDim() const { return _head_dim; }
+    size_t numBlocks() const { return _num_blocks; }
+    size_t numFreeBlocks() const { return _free.size(); }
+    llaisysDataType_t dtype() const { return _dtype; }
+    // 一个 block 在所有层中占用的字节数 (K、V 及 I8 的 scale)
+    size_t blockBytes() const { return blockBytes(numLayers(), _n_kv_heads, _head_dim, _block_size, _dtype); }
+    static size_t blockBytes(size_t n_layers, size_t n_kv_heads, size_t head_dim, size_t block_size,
+                             llaisysDataType_t dtype);
+
+    // 第 layer 层的 K/V 池，在 cache 的生命周期内不变
+    tensor_t keys(size_t layer) const { return _keys[layer]; }
+    tensor_t values(size_t layer) const { return _values[layer]; }
+    // I8 cache 的 scale 池，其他类型为 nullptr
+    tensor_t keyScales(size_t layer) const { return _key_scales.empty() ? nullptr : _key_scales[layer]; }
+    tensor_t valueScales(size_t layer) const { return _value_scales.empty() ? nullptr : _value_scales[layer]; }
+
+    // 分配或释放 block，使 seq 恰好覆盖 length 个 token; 缩短时丢弃 length 之后的 token。
+    // 之后写入的位置 (length 起) 若落在与其他持有者共享的 block 中，该 block 先被复制为 seq 独占 (copy-on-write)。
+    // 池中 block 不足时抛出 KVCacheFullError，seq 仍覆盖原来的 length
+    void resize(KVSequence &seq, size_t length);
+    // 空闲 block 少于 wanted 个时调用 reclaim 回收，直到够数或无可回收，返回此时的空闲 block 数
+    size_t reclaim(size_t wanted);
+
+    // 没有空闲 block 时调用，让其他持有者 (如 PrefixCache) 放弃 block; 已无可放弃时返回 false。
+    // 传入空函数取消
+    void setReclaim(std::function<bool()> reclaim) { _reclaim = std::move(reclaim); }
+
+    // 共享 block: 每次 retain 对应一次 release，引用计数归零时 block 回到空闲表
+    void retain(int32_t block);
+    void release(int32_t block);
+    size_t refCount(int32_t block) const { return _ref_count[block]; }
+
+private:
+    size_t _n_kv_heads;
+    size_t _head_dim;
+    size_t _block_size;
+    llaisysDataType_t _dtype;
+    llaisysDeviceType_t _device_type;
+    int _device_id;
+
+    size_t _num_blocks;
+    std::vector<tensor_t> _keys;
+    std::vector<tensor_t> _values;
+    std::vector<tensor_t> _key_scales;
+    std::vector<tensor_t> _value_scales;
+    // 空闲块号，后进先出: 刚释放的 block 最先被复用 (初始时栈顶为最小的块号)
+    std::vector<int32_t> _free;
+    std::vector<size_t> _ref_count;
+    std::function<bool()> _reclaim;
+
+    int32_t _allocate();
+    // 把 src 块在所有层中的内容复制到 dst 块
+    void _copy(int32_t dst, int32_t src);
+};
+
+} // namespace llaisys
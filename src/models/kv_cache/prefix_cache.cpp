@@ -0,0 +1,126 @@
+#include "prefix_cache.hpp"
+
+#include "../../utils.hpp"
+
+#include <algorithm>
+
+namespace llaisys {
+
+PrefixCache::PrefixCache(PagedKVCache &cache, size_t max_blocks) : _cache(cache), _max_blocks(max_blocks) {
+    // 池满时让出最久未使用的 block
+    _cache.setReclaim([this] { return _evict_one(); });
+}
+
+PrefixCache::~PrefixCache() {
+    _cache.setReclaim(nullptr);
+    _release_subtree(_root);
+}
+
+size_t PrefixCache::match(KVSequence &seq, const int64_t *tokens, size_t ntoken, size_t max_tokens) {
+    ASSERT(seq.blocks.empty(), "PrefixCache: match needs an empty sequence");
+    size_t block_size = _cache.blockSize();
+    size_t limit = std::min(ntoken, max_tokens) / block_size;
+
+    Node *node = &_root;
+    std::vector<int64_t> key;
+    std::vector<Node *> path;
+    size_t matched = 0;
+    while (matched < limit) {
+        key.assign(tokens + matched * block_size, tokens + (matched + 1) * block_size);
+        auto it = node->children.find(key);
+        if (it == node->children.end()) {
+            break;
+        }
+        node = it->second.get();
+        path.push_back(node);
+        _cache.retain(node->block);
+        seq.blocks.push_back(node->block);
+        ++matched;
+    }
+    _touch(path);
+    seq.length = matched * block_size;
+
+    ++_stats.lookups;
+    _stats.lookup_tokens += ntoken;
+    if (matched > 0) {
+        ++_stats.hits;
+        _stats.hit_tokens += seq.length;
+    }
+    return seq.length;
+}
+
+void PrefixCache::insert(const KVSequence &seq, const int64_t *tokens, size_t ntoken) {
+    size_t block_size = _cache.blockSize();
+    size_t full = std::min(ntoken, seq.length) / block_size;
+
+    Node *node = &_root;
+    std::vector<Node *> path;
+    for (size_t b = 0; b < full; ++b) {
+        auto it = node->children.try_emplace(std::vector<int64_t>(tokens + b * block_size, tokens + (b + 1) * block_size))
+                      .first;
+        auto &child = it->second;
+        if (!child) {
+            child = std::make_unique<Node>();
+            child->block = seq.blocks[b];
+            child->parent = node;
+            child->key = &it->first;
+            _cache.retain(child->block);
+            ++_stats.cached_blocks;
+        }
+        node = child.get();
+        path.push_back(node);
+    }
+    _touch(path);
+    while (_stats.cached_blocks > _max_blocks && _evict_one()) {
+    }
+}
+
+void PrefixCache::_lru_unlink(Node *node) {
+    (node->lru_prev ? node->lru_prev->lru_next : _lru_head) = node->lru_next;
+    (node->lru_next ? node->lru_next->lru_prev : _lru_tail) = node->lru_prev;
+    node->lru_prev = node->lru_next = nullptr;
+}
+
+void PrefixCache::_lru_push(Node *node) {
+    node->lru_prev = _lru_tail;
+    node->lru_next = nullptr;
+    (_lru_tail ? _lru_tail->lru_next : _lru_head) = node;
+    _lru_tail = node;
+}
+
+void PrefixCache::_touch(const std::vector<Node *> &path) {
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        if (*it != _lru_tail) {
+            if ((*it)->lru_prev || _lru_head == *it) {
+                _lru_unlink(*it);
+            }
+            _lru_push(*it);
+        }
+    }
+}
+
+bool PrefixCache::_evict_one() {
+    // 只淘汰叶子: 内部节点是其子孙的前缀，先于子孙淘汰会让子孙不可达
+    Node *victim = _lru_head;
+    if (!victim) {
+        return false;
+    }
+    ASSERT(victim->children.empty(), "PrefixCache: least recently used node must be a leaf");
+    _lru_unlink(victim);
+    _cache.release(victim->block);
+    auto &siblings = victim->parent->children;
+    siblings.erase(siblings.find(*victim->key));
+    --_stats.cached_blocks;
+    ++_stats.evicted_blocks;
+    return true;
+}
+
+void PrefixCache::_release_subtree(Node &node) {
+    for (auto &entry : node.children) {
+        _cache.release(entry.second->block);
+        _release_subtree(*entry.second);
+    }
+    node.children.clear();
+}
+
+} // namespace llaisys
@@ -0,0 +1,68 @@
+#pragma once
+#include "paged_kv_cache.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace llaisys {
+
+// 前缀缓存的命中统计
+struct PrefixCacheStats {
+    size_t lookups = 0;       // match 的次数
+    size_t hits = 0;          // 至少复用了一个 block 的 match 次数
+    size_t lookup_tokens = 0; // match 查询的 token 总数
+    size_t hit_tokens = 0;    // 从缓存复用 (无需 prefill) 的 token 总数
+    size_t evicted_blocks = 0;
+    size_t cached_blocks = 0; // 当前树中持有的 block 数
+};
+
+// 跨请求复用 KV 的前缀缓存: 以 block 为粒度的基数树，每个节点对应一个写满的 block，
+// 以其 block_size 个 token 为键，从根到节点的路径即该 block 之前的全部 token。
+// 树对其中每个 block 持有一个引用 (PagedKVCache::retain)，序列 match 时共享这些 block，
+// 因此命中不复制任何 KV。树中的 block 数超过 max_blocks 时按 LRU 逐个淘汰叶子节点;
+// PagedKVCache 的池没有空闲 block 时也按同样的顺序淘汰 (见 PagedKVCache::setReclaim)。
+// 淘汰的 block 回到 PagedKVCache 的空闲表，池本身不缩小。
+class PrefixCache {
+public:
+    PrefixCache(PagedKVCache &cache, size_t max_blocks);
+    ~PrefixCache();
+
+    // 把空序列 seq 接到 tokens[0..ntoken) 在树中的最长前缀上，返回复用的 token 数 (block 对齐)。
+    // 最多复用 max_tokens 个 token，调用方借此保留至少一个 token 做前向以得到下一个 token 的预测
+    size_t match(KVSequence &seq, const int64_t *tokens, size_t ntoken, size_t max_tokens);
+    // 把 seq 中写满的 block (存放 tokens[0..ntoken) 的 KV) 加入树，已有的节点只更新访问时间
+    void insert(const KVSequence &seq, const int64_t *tokens, size_t ntoken);
+
+    const PrefixCacheStats &stats() const { return _stats; }
+
+private:
+    struct Node {
+        int32_t block = -1;
+        Node *parent = nullptr;
+        const std::vector<int64_t> *key = nullptr; // 在 parent->children 中的键
+        Node *lru_prev = nullptr;
+        Node *lru_next = nullptr;
+        std::map<std::vector<int64_t>, std::unique_ptr<Node>> children;
+    };
+
+    PagedKVCache &_cache;
+    size_t _max_blocks;
+    Node _root;
+    PrefixCacheStats _stats;
+    // 除根以外的所有节点按最近访问排成的侵入式链表，表头最久未使用。
+    // 访问一条路径时从深到浅依次移到表尾，子孙因此总排在祖先之前，表头必为叶子
+    Node *_lru_head = nullptr;
+    Node *_lru_tail = nullptr;
+
+    void _lru_unlink(Node *node);
+    void _lru_push(Node *node);
+    // 把 path 上的节点由深到浅移到表尾
+    void _touch(const std::vector<Node *> &path);
+    // 淘汰最久未使用的叶子节点 (表头)，树为空时返回 false
+    bool _evict_one();
+    void _release_subtree(Node &node);
+};
+
+} // namespace llaisys
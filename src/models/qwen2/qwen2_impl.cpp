@@ -1,55 +1,75 @@
 #include "qwen2_impl.hpp"
 #include "../../ops/ops.hpp"
 #include "../../utils.hpp"
+#include "../kv_cache/kv_session.hpp"
 #include <iostream>
 
+#include <algorithm>
 #include <cmath>    // 解决 std::sqrt 报错
-#include <cstring>  // 解决 std::memcpy 报错
 
 namespace llaisys {
 
 Qwen2Impl::Qwen2Impl(const Qwen2Config& config) : _config(config) {
-    _init_params();
     _init_kv_cache();
+    _init_params();
 }
 
 void Qwen2Impl::_init_params() {
-    // 预分配中间变量，避免推理时频繁 malloc
-    size_t head_dim = _config.hidden_dim / _config.n_heads;
-    
-    _input_embed = Tensor::create({1, 1, (size_t)_config.hidden_dim}, LLAISYS_DTYPE_F32);
-    _hidden_state = Tensor::create({1, 1, (size_t)_config.hidden_dim}, LLAISYS_DTYPE_F32);
-    _norm_out = Tensor::create({1, 1, (size_t)_config.hidden_dim}, LLAISYS_DTYPE_F32);
+    // 预分配中间变量，避免推理时频繁 malloc; 逐 token 解码只需要 1 行，prefill 时按需扩容
+    _reserve(1);
     
-    _q = Tensor::create({1, (size_t)_config.n_heads, head_dim}, LLAISYS_DTYPE_F32);
-    _k = Tensor::create({1, (size_t)_config.n_kv_heads, head_dim}, LLAISYS_DTYPE_F32);
-    _v = Tensor::create({1, (size_t)_config.n_kv_heads, head_dim}, LLAISYS_DTYPE_F32);
-    _attn_ctx = Tensor::create({1, 1, (size_t)_config.hidden_dim}, LLAISYS_DTYPE_F32);
-    _attn_out = Tensor::create({1, 1, (size_t)_config.hidden_dim}, LLAISYS_DTYPE_F32);
-    
-    _gate = Tensor::create({1, 1, (size_t)_config.intermediate_dim}, LLAISYS_DTYPE_F32);
-    _up = Tensor::create({1, 1, (size_t)_config.intermediate_dim}, LLAISYS_DTYPE_F32);
-    _down = Tensor::create({1, 1, (size_t)_config.hidden_dim}, LLAISYS_DTYPE_F32); // Reuse shape
-    
-    _logits = Tensor::create({1, 1, (size_t)_config.vocab_size}, LLAISYS_DTYPE_F32);
+    _logits = Tensor::create({1, (size_t)_config.vocab_size}, LLAISYS_DTYPE_F32);
     _token_out = Tensor::create({1}, LLAISYS_DTYPE_I64);
     _prob_out = Tensor::create({1}, LLAISYS_DTYPE_F32);
-    
-    _pos_ids = Tensor::create({1}, LLAISYS_DTYPE_I64);
+
+    size_t head_dim = _config.hidden_dim / _config.n_heads;
+    _rope_table = Tensor::create({(size_t)_config.max_seq_len, 2, head_dim / 2}, LLAISYS_DTYPE_F32);
+    ops::rope_table(_rope_table, _config.rope_theta);
+}
+
+void Qwen2Impl::_reserve(size_t ntoken) {
+    if (ntoken <= _capacity) {
+        return;
+    }
+    size_t head_dim = _config.hidden_dim / _config.n_heads;
+    size_t hidden = (size_t)_config.hidden_dim;
+    size_t qkv_dim = (size_t)(_config.n_heads + 2 * _config.n_kv_heads) * head_dim;
+
+    _token_ids = Tensor::create({ntoken}, LLAISYS_DTYPE_I64);
+    _block_tables = Tensor::create({ntoken, _max_blocks}, LLAISYS_DTYPE_I32);
+    _hidden_state = Tensor::create({ntoken, hidden}, LLAISYS_DTYPE_F32);
+    _norm_out = Tensor::create({ntoken, hidden}, LLAISYS_DTYPE_F32);
+    _qkv = Tensor::create({ntoken, qkv_dim}, LLAISYS_DTYPE_F32);
+    _q = Tensor::create({ntoken, (size_t)_config.n_heads, head_dim}, LLAISYS_DTYPE_F32);
+    _attn_ctx = Tensor::create({ntoken, hidden}, LLAISYS_DTYPE_F32);
+    _gate = Tensor::create({ntoken, (size_t)_config.intermediate_dim}, LLAISYS_DTYPE_F32);
+    _capacity = ntoken;
 }
 
 void Qwen2Impl::_init_kv_cache() {
+    // 所有序列共享一个 block 池，block 随序列增长从池中分配
     size_t head_dim = _config.hidden_dim / _config.n_heads;
-    for (int i = 0; i < _config.n_layers; ++i) {
-        auto k_cache = Tensor::create({(size_t)_config.max_seq_len, (size_t)_config.n_kv_heads, head_dim}, LLAISYS_DTYPE_F32);
-        auto v_cache = Tensor::create({(size_t)_config.max_seq_len, (size_t)_config.n_kv_heads, head_dim}, LLAISYS_DTYPE_F32);
-        _kv_cache.emplace_back(k_cache, v_cache);
+    size_t block_size = _config.kv_block_size > 0 ? (size_t)_config.kv_block_size : (size_t)QWEN2_DEFAULT_KV_BLOCK_SIZE;
+    llaisysDataType_t dtype = _config.kv_cache_dtype == LLAISYS_DTYPE_INVALID ? LLAISYS_DTYPE_F32 : _config.kv_cache_dtype;
+    _max_blocks = ((size_t)_config.max_seq_len + block_size - 1) / block_size;
+
+    size_t block_bytes =
+        PagedKVCache::blockBytes((size_t)_config.n_layers, (size_t)_config.n_kv_heads, head_dim, block_size, dtype);
+    size_t prefix_blocks = _config.prefix_cache_mb > 0 ? ((size_t)_config.prefix_cache_mb << 20) / block_bytes : 0;
+    size_t kv_cache_mb = _config.kv_cache_mb > 0 ? (size_t)_config.kv_cache_mb : (size_t)QWEN2_DEFAULT_KV_CACHE_MB;
+    size_t num_blocks = (kv_cache_mb << 20) / block_bytes;
+    CHECK_ARGUMENT(num_blocks > 0, "Qwen2: kv_cache_mb is smaller than one block");
+    _kv_cache = std::make_unique<PagedKVCache>((size_t)_config.n_layers, (size_t)_config.n_kv_heads, head_dim,
+                                               block_size, num_blocks, dtype);
+
+    if (prefix_blocks > 0) {
+        _prefix_cache = std::make_unique<PrefixCache>(*_kv_cache, prefix_blocks);
     }
 }
 
 // 辅助函数：按名称查找或创建权重 Tensor
 // 注意：这里我们通过名称来判断权重的形状，这是一种简化处理
-void Qwen2Impl::load_tensor(const std::string& name, void* data) {
+void Qwen2Impl::load_tensor(const std::string& name, void* data, llaisysDataType_t dtype) {
     tensor_t tensor;
     
     // 简单的形状推断逻辑 (适配 DeepSeek-R1-Distill-Qwen-1.5B)
@@ -90,125 +110,463 @@ void Qwen2Impl::load_tensor(const std::string& name, void* data) {
         return;
     }
 
-    // 创建张量并加载数据 (假设数据是 F32/BF16/F16，这里为了简化，我们假设 Python 端已经处理好并传入指针)
-    // 注意：实际应用中需要匹配 dtype。这里我们默认模型权重是 BF16 (根据作业描述)
-    tensor = Tensor::create(shape, LLAISYS_DTYPE_F32); 
+    // 权重保持 checkpoint 的 dtype (F32/BF16/F16)，激活仍为 F32，
+    // 算子内部以 F32 累加，权重在寄存器中转换
+    CHECK_ARGUMENT(dtype == LLAISYS_DTYPE_F32 || dtype == LLAISYS_DTYPE_BF16 || dtype == LLAISYS_DTYPE_F16,
+                   "Qwen2: weights must be F32, BF16 or F16");
+    tensor = Tensor::create(shape, dtype);
     tensor->load(data);
+
+    bool is_projection = name.find("_proj.weight") != std::string::npos;
+    bool is_vocab = name == "model.embed_tokens.weight" || name == "lm_head.weight";
+    if (_config.weight_quant == QWEN2_WEIGHT_QUANT_INT8 && is_projection) {
+        auto q = Tensor::create(shape, LLAISYS_DTYPE_I8);
+        auto scale = Tensor::create({shape[0]}, LLAISYS_DTYPE_F32);
+        ops::quantize(q, scale, tensor);
+        tensor = q;
+        _weight_scales[name] = scale;
+    } else if (_config.weight_quant == QWEN2_WEIGHT_QUANT_Q4 && (is_projection || is_vocab)) {
+        size_t group = (size_t)_config.quant_group_size;
+        CHECK_ARGUMENT(group > 0 && shape[1] % group == 0, "Qwen2: q4 group size must divide the weight rows");
+        auto q = Tensor::create({shape[0], shape[1] / 2}, LLAISYS_DTYPE_U8);
+        auto scale = Tensor::create({shape[0], shape[1] / group}, LLAISYS_DTYPE_F16);
+        tensor_t zero = _config.quant_zero_point ? Tensor::create({shape[0], shape[1] / group}, LLAISYS_DTYPE_U8) : nullptr;
+        ops::quantize(q, scale, tensor, zero);
+        tensor = q;
+        _weight_scales[name] = scale;
+        if (zero) {
+            _weight_zeros[name] = zero;
+        }
+    }
     
     _weights[name] = tensor;
 }
 
-int Qwen2Impl::forward(int token, int pos) {
+tensor_t Qwen2Impl::_scale_of(const std::string& weight_name) const {
+    auto it = _weight_scales.find(weight_name);
+    return it == _weight_scales.end() ? nullptr : it->second;
+}
+
+tensor_t Qwen2Impl::_zero_of(const std::string& weight_name) const {
+    auto it = _weight_zeros.find(weight_name);
+    return it == _weight_zeros.end() ? nullptr : it->second;
+}
+
+void Qwen2Impl::_linear(tensor_t out, tensor_t in, const std::string& weight_name, tensor_t bias, tensor_t residual) {
+    ops::linear(out, in, _weights[weight_name], bias, _scale_of(weight_name), _zero_of(weight_name), residual);
+}
+
+namespace {
+// 按第 0 维拼接若干连续张量 (dtype 与其余维度必须一致)
+tensor_t concat_rows(const std::vector<tensor_t>& parts) {
+    auto shape = parts[0]->shape();
+    shape[0] = 0;
+    for (const auto& part : parts) {
+        CHECK_SAME_DTYPE(part->dtype(), parts[0]->dtype());
+        CHECK_ARGUMENT(part->ndim() == shape.size() && part->isContiguous(), "Qwen2: cannot concatenate weights");
+        for (size_t d = 1; d < shape.size(); ++d) {
+            CHECK_ARGUMENT(part->shape()[d] == shape[d], "Qwen2: cannot concatenate weights");
+        }
+        shape[0] += part->shape()[0];
+    }
+
+    auto out = Tensor::create(shape, parts[0]->dtype(), parts[0]->deviceType(), parts[0]->deviceId());
+    std::byte* dst = out->data();
+    for (const auto& part : parts) {
+        size_t bytes = part->numel() * part->elementSize();
+        core::context().runtime().api()->memcpy_sync(dst, part->data(), bytes, LLAISYS_MEMCPY_D2D);
+        dst += bytes;
+    }
+    return out;
+}
+
+// 按行交错两个形状相同的连续张量: out[2i] = a[i], out[2i + 1] = b[i]
+tensor_t interleave_rows(const tensor_t& a, const tensor_t& b) {
+    CHECK_SAME_DTYPE(a->dtype(), b->dtype());
+    CHECK_SAME_SHAPE(a->shape(), b->shape());
+    CHECK_ARGUMENT(a->isContiguous() && b->isContiguous(), "Qwen2: cannot interleave weights");
+
+    auto shape = a->shape();
+    size_t rows = shape[0];
+    shape[0] *= 2;
+    auto out = Tensor::create(shape, a->dtype(), a->deviceType(), a->deviceId());
+    size_t row_bytes = a->numel() / rows * a->elementSize();
+    auto api = core::context().runtime().api();
+    for (size_t i = 0; i < rows; ++i) {
+        api->memcpy_sync(out->data() + (2 * i) * row_bytes, a->data() + i * row_bytes, row_bytes, LLAISYS_MEMCPY_D2D);
+        api->memcpy_sync(out->data() + (2 * i + 1) * row_bytes, b->data() + i * row_bytes, row_bytes, LLAISYS_MEMCPY_D2D);
+    }
+    return out;
+}
+} // namespace
+
+void Qwen2Impl::_fuse_qkv(const std::string& layer_prefix) {
+    const std::string names[3] = {
+        layer_prefix + "self_attn.q_proj.",
+        layer_prefix + "self_attn.k_proj.",
+        layer_prefix + "self_attn.v_proj.",
+    };
+    const std::string fused = layer_prefix + "self_attn.qkv_proj.";
+
+    auto collect = [&](std::unordered_map<std::string, tensor_t>& map, const std::string& suffix) {
+        std::vector<tensor_t> parts;
+        for (const auto& name : names) {
+            auto it = map.find(name + suffix);
+            if (it != map.end() && it->second) {
+                parts.push_back(it->second);
+            }
+        }
+        CHECK_ARGUMENT(parts.empty() || parts.size() == 3, "Qwen2: q/k/v projections must be loaded together");
+        for (const auto& name : names) {
+            map.erase(name + suffix);
+        }
+        if (!parts.empty()) {
+            map[fused + suffix] = concat_rows(parts);
+        }
+    };
+
+    // 量化是逐行 (INT8) 或逐行分组 (Q4) 的，按行拼接后 scale / zero point 依然一一对应
+    collect(_weight_scales, "weight");
+    collect(_weight_zeros, "weight");
+    collect(_weights, "bias");
+    collect(_weights, "weight");
+}
+
+void Qwen2Impl::_fuse_gate_up(const std::string& layer_prefix) {
+    const std::string gate = layer_prefix + "mlp.gate_proj.weight";
+    const std::string up = layer_prefix + "mlp.up_proj.weight";
+    const std::string fused = layer_prefix + "mlp.gate_up_proj.weight";
+
+    auto fuse = [&](std::unordered_map<std::string, tensor_t>& map) {
+        auto g = map.find(gate);
+        auto u = map.find(up);
+        CHECK_ARGUMENT((g == map.end()) == (u == map.end()), "Qwen2: gate/up projections must be loaded together");
+        if (g == map.end()) {
+            return;
+        }
+        map[fused] = interleave_rows(g->second, u->second);
+        map.erase(gate);
+        map.erase(up);
+    };
+
+    // 同 QKV，量化参数逐行对应，跟着权重一起交错即可
+    fuse(_weight_scales);
+    fuse(_weight_zeros);
+    fuse(_weights);
+}
+
+void Qwen2Impl::_pack_weights() {
+    // 共享词表时 lm_head 与 embedding 是同一个张量，embedding 需要行主序，不能打包
+    bool tied = _weights["lm_head.weight"] == _weights["model.embed_tokens.weight"];
+    for (auto& [name, weight] : _weights) {
+        bool is_projection = name.size() > 12 && name.compare(name.size() - 12, 12, "_proj.weight") == 0;
+        bool is_head = name == "lm_head.weight" && !tied;
+        // q4 权重在内核里按块反量化，没有对应的打包格式
+        if (!weight || !(is_projection || is_head) || weight->dtype() == LLAISYS_DTYPE_U8) {
+            continue;
+        }
+        weight = ops::linear_pack_weight(weight);
+    }
+}
+
+void Qwen2Impl::_finalize_weights() {
     if (_weights.find("lm_head.weight") == _weights.end()) {
         if (_weights.find("model.embed_tokens.weight") != _weights.end()) {
             _weights["lm_head.weight"] = _weights["model.embed_tokens.weight"];
+            // 共享词表时量化参数也一起共享
+            if (_weight_scales.count("model.embed_tokens.weight")) {
+                _weight_scales["lm_head.weight"] = _weight_scales["model.embed_tokens.weight"];
+            }
+            if (_weight_zeros.count("model.embed_tokens.weight")) {
+                _weight_zeros["lm_head.weight"] = _weight_zeros["model.embed_tokens.weight"];
+            }
         } else {
             std::cerr << "Critical Error: Embed tokens not found, cannot tie weights!" << std::endl;
         }
     }
-    // 1. Embedding
-    tensor_t index_tensor = Tensor::create({1}, LLAISYS_DTYPE_I64);
-    long token_val = token;
-    index_tensor->load(&token_val);
-    
-    ops::embedding(_hidden_state, index_tensor, _weights["model.embed_tokens.weight"]);
 
-    // Set pos_ids
-    long pos_val = pos;
-    _pos_ids->load(&pos_val);
+    // 一次 GEMM 算完 QKV: 只读一遍 _norm_out，N 更大也更利于多线程切分
+    for (int i = 0; i < _config.n_layers; ++i) {
+        _fuse_qkv("model.layers." + std::to_string(i) + ".");
+    }
+    // gate/up 交错存放，一次 GEMM 后在写回时直接算 SwiGLU，gate/up 本身不落到内存
+    for (int i = 0; i < _config.n_layers; ++i) {
+        _fuse_gate_up("model.layers." + std::to_string(i) + ".");
+    }
+    _pack_weights();
+    _weights_ready = true;
+}
+
+int Qwen2Impl::forward(int token, int pos) {
+    int64_t token_id = token;
+    return forward(&token_id, 1, pos);
+}
+
+size_t Qwen2Impl::_chunk_size() const {
+    return _config.prefill_chunk_size > 0 ? (size_t)_config.prefill_chunk_size : (size_t)QWEN2_DEFAULT_PREFILL_CHUNK;
+}
+
+Qwen2Impl::Sequence& Qwen2Impl::_rewind(int seq_id, size_t pos) {
+    Sequence& seq = _sequences[seq_id];
+    // 从 pos 开始重写序列，pos 之后原有的 token 作废
+    CHECK_ARGUMENT(pos <= seq.kv.length, "Qwen2: forward must continue the cached sequence");
+    if (_prefix_cache && pos < seq.kv.length) {
+        _prefix_cache->insert(seq.kv, seq.tokens.data(), seq.kv.length);
+    }
+    _kv_cache->resize(seq.kv, pos);
+    seq.tokens.resize(pos);
+    return seq;
+}
+
+int Qwen2Impl::forward(const int64_t* tokens, size_t ntoken, int pos, int seq_id) {
+    CHECK_ARGUMENT(ntoken > 0, "Qwen2: forward needs at least one token");
+    CHECK_ARGUMENT(pos >= 0 && (size_t)pos + ntoken <= (size_t)_config.max_seq_len,
+                   "Qwen2: sequence exceeds max_seq_len");
+    if (!_weights_ready) {
+        _finalize_weights();
+    }
+    Sequence& seq = _rewind(seq_id, (size_t)pos);
+
+    // 新请求先接到最长的已缓存前缀上，只 prefill 剩下的 token (至少留一个以得到预测)
+    size_t done = 0;
+    if (_prefix_cache && pos == 0) {
+        done = _prefix_cache->match(seq.kv, tokens, ntoken, ntoken - 1);
+        seq.tokens.assign(tokens, tokens + done);
+    }
+
+    // 逐块前向: 每块读取前面所有块已写入 cache 的 K/V，工作区在块之间复用
+    size_t chunk = _chunk_size();
+    _reserve(std::min(ntoken - done, chunk));
+    size_t n = 0;
+    for (; done < ntoken; done += n) {
+        n = std::min(chunk, ntoken - done);
+        _forward_rows(tokens + done, {Segment{&seq, 0, n, (size_t)pos + done}});
+    }
+    int next_token;
+    _predict(n - 1, 1, &next_token);
+    return next_token;
+}
+
+void Qwen2Impl::forward_batch(const int* seq_ids, const int64_t* tokens, const int* positions, size_t n,
+                              int* next_tokens) {
+    CHECK_ARGUMENT(n > 0, "Qwen2: forward_batch needs at least one sequence");
+    if (!_weights_ready) {
+        _finalize_weights();
+    }
+    // 先检查全部 n 项再回退任何序列，参数有误时所有序列保持原样
+    for (size_t i = 0; i < n; ++i) {
+        CHECK_ARGUMENT(positions[i] >= 0 && positions[i] < _config.max_seq_len, "Qwen2: sequence exceeds max_seq_len");
+        auto it = _sequences.find(seq_ids[i]);
+        size_t length = it == _sequences.end() ? 0 : it->second.kv.length;
+        CHECK_ARGUMENT((size_t)positions[i] <= length, "Qwen2: forward must continue the cached sequence");
+        for (size_t j = 0; j < i; ++j) {
+            CHECK_ARGUMENT(seq_ids[j] != seq_ids[i], "Qwen2: forward_batch got the same sequence twice");
+        }
+    }
+    std::vector<Segment> segments;
+    segments.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        segments.push_back(Segment{&_rewind(seq_ids[i], (size_t)positions[i]), i, 1, (size_t)positions[i]});
+    }
+    _reserve(n);
+    _forward_rows(tokens, segments);
+    _predict(0, n, next_tokens);
+}
+
+size_t Qwen2Impl::kv_blocks_for(size_t ntoken) const {
+    return (ntoken + _kv_cache->blockSize() - 1) / _kv_cache->blockSize();
+}
+
+void Qwen2Impl::release_sequence(int seq_id) {
+    auto it = _sequences.find(seq_id);
+    if (it == _sequences.end()) {
+        return;
+    }
+    _rewind(seq_id, 0);
+    _sequences.erase(it);
+}
+
+PrefixCacheStats Qwen2Impl::prefix_cache_stats() const {
+    return _prefix_cache ? _prefix_cache->stats() : PrefixCacheStats{};
+}
+
+void Qwen2Impl::save_session(const std::string& path, int seq_id) const {
+    auto it = _sequences.find(seq_id);
+    static const Sequence empty;
+    const Sequence& seq = it == _sequences.end() ? empty : it->second;
+    save_kv_session(path, *_kv_cache, seq.kv, seq.tokens.data(), _config_hash());
+}
+
+std::vector<int64_t> Qwen2Impl::load_session(const std::string& path, int seq_id) {
+    // 先读入一个新序列，文件不存在或不符时抛出，原序列保持不变
+    Sequence loaded;
+    try {
+        loaded.tokens = load_kv_session(path, *_kv_cache, loaded.kv, _config_hash(), (size_t)_config.max_seq_len);
+    } catch (...) {
+        _kv_cache->resize(loaded.kv, 0);
+        throw;
+    }
+    // 成功后才替换: 与 forward 换新请求一样，旧序列先交给前缀缓存
+    Sequence& seq = _rewind(seq_id, 0);
+    std::swap(seq, loaded);
+    return seq.tokens;
+}
+
+uint64_t Qwen2Impl::_config_hash() const {
+    // FNV-1a; 块大小、分块与缓存容量不影响 KV 内容，不参与哈希
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const void* data, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) {
+            hash = (hash ^ static_cast<const uint8_t*>(data)[i]) * 1099511628211ull;
+        }
+    };
+    bool q4 = _config.weight_quant == QWEN2_WEIGHT_QUANT_Q4;
+    int fields[] = {_config.vocab_size, _config.hidden_dim, _config.intermediate_dim, _config.n_layers,
+                    _config.n_heads, _config.n_kv_heads, _config.weight_quant,
+                    q4 ? _config.quant_group_size : 0, q4 ? _config.quant_zero_point : 0};
+    mix(fields, sizeof(fields));
+    mix(&_config.rope_theta, sizeof(float));
+    mix(&_config.rms_norm_eps, sizeof(float));
+    return hash;
+}
+
+void Qwen2Impl::_forward_rows(const int64_t* tokens, const std::vector<Segment>& segments) {
+    size_t n = segments.back().row + segments.back().n;
+    size_t n_heads = (size_t)_config.n_heads;
+    size_t n_kv_heads = (size_t)_config.n_kv_heads;
+    size_t head_dim = _config.hidden_dim / _config.n_heads;
+
+    // 本次前向用到的前 n 行
+    auto hidden_state = _hidden_state->slice(0, 0, n);
+    auto norm_out = _norm_out->slice(0, 0, n);
+    auto qkv = _qkv->slice(0, 0, n);
+    auto q = _q->slice(0, 0, n);
+    auto attn_ctx = _attn_ctx->slice(0, 0, n);
+    auto attn_heads = attn_ctx->view({n, n_heads, head_dim});
+    auto gate = _gate->slice(0, 0, n);
+
+    // QKV 输出按头看作 [n, n_head + 2 * n_kv_head, head_dim]，q/k/v 是其中按头切出的跨步视图
+    auto qkv_heads = qkv->view({n, n_heads + 2 * n_kv_heads, head_dim});
+    auto q_proj = qkv_heads->slice(1, 0, n_heads);
+    auto k_proj = qkv_heads->slice(1, n_heads, n_heads + n_kv_heads);
+    auto v_proj = qkv_heads->slice(1, n_heads + n_kv_heads, n_heads + 2 * n_kv_heads);
+
+    // 1. Embedding
+    auto token_ids = _token_ids->slice(0, 0, n);
+    token_ids->load(tokens);
+    ops::embedding(hidden_state, token_ids, _weights["model.embed_tokens.weight"],
+                   _scale_of("model.embed_tokens.weight"), _zero_of("model.embed_tokens.weight"));
 
     float sqrt_head_dim = std::sqrt((float)_config.hidden_dim / _config.n_heads);
     float scale = 1.0f / sqrt_head_dim;
 
+    // 前向没有完成 (池中 block 不足或算子抛出) 时把已扩展的段退回 segment.pos 再抛出，
+    // 否则未写入 K/V 的位置会连同 token 留在序列里，回退时被当作有效前缀插入前缀缓存
+    struct Rollback {
+        PagedKVCache& cache;
+        const std::vector<Segment>& segments;
+        size_t resized = 0;
+        bool done = false;
+        ~Rollback() {
+            for (size_t s = 0; !done && s < resized; ++s) {
+                // resize 到 pos + n 时 pos 所在的 block 已变为独占，缩短不需要分配
+                cache.resize(segments[s].seq->kv, segments[s].pos);
+                segments[s].seq->tokens.resize(segments[s].pos);
+            }
+        }
+    } rollback{*_kv_cache, segments};
+
+    // 先为所有段分配新 token 的 block，全部成功后才写入 token，
+    // 再把各段序列的 block table 同步到 _block_tables 的对应行
+    for (; rollback.resized < segments.size(); ++rollback.resized) {
+        const Segment& segment = segments[rollback.resized];
+        _kv_cache->resize(segment.seq->kv, segment.pos + segment.n);
+    }
+    std::vector<tensor_t> block_tables;
+    block_tables.reserve(segments.size());
+    for (const Segment& segment : segments) {
+        Sequence& seq = *segment.seq;
+        seq.tokens.insert(seq.tokens.end(), tokens + segment.row, tokens + segment.row + segment.n);
+        size_t i = block_tables.size();
+        auto block_table = _block_tables->slice(0, i, i + 1)->view({_max_blocks})->slice(0, 0, seq.kv.blocks.size());
+        block_table->load(seq.kv.blocks.data());
+        block_tables.push_back(block_table);
+    }
+
     // 2. Layers Loop
     for (int i = 0; i < _config.n_layers; ++i) {
         std::string layer_prefix = "model.layers." + std::to_string(i) + ".";
         
         // --- Attention Block ---
         // Pre-Norm
-        ops::rms_norm(_norm_out, _hidden_state, _weights[layer_prefix + "input_layernorm.weight"], _config.rms_norm_eps);
-
-        // QKV Proj
-        ops::linear(_q, _norm_out, _weights[layer_prefix + "self_attn.q_proj.weight"], _weights[layer_prefix + "self_attn.q_proj.bias"]);
-        ops::linear(_k, _norm_out, _weights[layer_prefix + "self_attn.k_proj.weight"], _weights[layer_prefix + "self_attn.k_proj.bias"]);
-        ops::linear(_v, _norm_out, _weights[layer_prefix + "self_attn.v_proj.weight"], _weights[layer_prefix + "self_attn.v_proj.bias"]);
-
-        // RoPE
-        ops::rope(_q, _q, _pos_ids, _config.rope_theta);
-        ops::rope(_k, _k, _pos_ids, _config.rope_theta);
-
-        // Update KV Cache
-        // cache[pos] = current_k/v
-        // Slice cache to get a view of current row to fill
-        auto k_slot = _kv_cache[i].first->slice(0, pos, pos + 1);
-        auto v_slot = _kv_cache[i].second->slice(0, pos, pos + 1);
-        
-        // 我们需要把 [1, n_kv, head_dim] 的 _k 复制到 k_slot
-        // 简单起见，利用 memcpy 或者 ops::rearrange (如果实现了)。这里可以用 load 因为数据都在 device 上
-        // 但 load 接收 host 指针。正确的做法是实现一个 copy 算子。
-        // 这里为了作业简单，我们利用 contiguous 机制或者 slice 机制。
-        // 由于作业1并未强制要求实现 device-to-device copy 接口，我们这里简单粗暴地用 memcpy_sync
-        // 或者直接假设 _k 和 k_slot 内存连续。
-        // Hack: 利用 Tensor::load 实际上做的是 Host->Device，这里我们需要 Device->Device。
-        // 最好的办法是使用 src/utils.hpp 里的 copy 或者 ops 里的 rearrange (Task 2.9)。
-        // 假设你没做 2.9，我们这里手动拷贝一下（仅限 CPU）
-        if (_k->deviceType() == LLAISYS_DEVICE_CPU) {
-            std::memcpy(k_slot->data(), _q->data() /*dummy*/, 0); // Oops logic
-            std::memcpy(k_slot->data(), _k->data(), _k->numel() * _k->elementSize());
-            std::memcpy(v_slot->data(), _v->data(), _v->numel() * _v->elementSize());
-        }
+        ops::rms_norm(norm_out, hidden_state, _weights[layer_prefix + "input_layernorm.weight"], _config.rms_norm_eps);
 
-        // Prepare Attention Inputs (View from 0 to pos+1)
-        auto k_view = _kv_cache[i].first->slice(0, 0, pos + 1);
-        auto v_view = _kv_cache[i].second->slice(0, 0, pos + 1);
+        // QKV Proj: 一次 GEMM 算出全部 n 个 token 的 q/k/v
+        _linear(qkv, norm_out, layer_prefix + "self_attn.qkv_proj.weight", _weights[layer_prefix + "self_attn.qkv_proj.bias"]);
 
-        // Self Attention
-        ops::self_attention(_attn_ctx, _q, k_view, v_view, scale);
+        for (size_t s = 0; s < segments.size(); ++s) {
+            const Segment& segment = segments[s];
+            size_t begin = segment.row, end = segment.row + segment.n;
+            // RoPE + Update KV Cache: 一遍旋转 q 写入 q，旋转 k 并与 v 一起写入各自的 block，
+            // 写入时转换 (或量化) 为 cache 的类型
+            ops::rope_kv_append(q->slice(0, begin, end), _kv_cache->keys(i), _kv_cache->values(i),
+                                _kv_cache->keyScales(i), _kv_cache->valueScales(i), q_proj->slice(0, begin, end),
+                                k_proj->slice(0, begin, end), v_proj->slice(0, begin, end), _rope_table,
+                                block_tables[s], segment.pos);
 
-        // Output Proj
-        ops::linear(_attn_out, _attn_ctx, _weights[layer_prefix + "self_attn.o_proj.weight"], nullptr);
+            // Self Attention: 每段经自己的 block table 读取 [0, pos + n) 的 K/V，第 t 个 query 位于 pos + t
+            ops::paged_attention(attn_heads->slice(0, begin, end), q->slice(0, begin, end), _kv_cache->keys(i),
+                                 _kv_cache->values(i), _kv_cache->keyScales(i), _kv_cache->valueScales(i),
+                                 block_tables[s], segment.pos + segment.n, scale);
+        }
 
-        // Residual Add
-        ops::add(_hidden_state, _hidden_state, _attn_out);
+        // Output Proj + Residual Add: 直接累加到残差流 hidden_state。
+        // 不改用 ops::add_rms_norm: 那需要先把投影写到另一个缓冲区再读回，比这里多一遍读写，
+        // 与这里的 epilogue 累加 + rms_norm 相比 prefill (M = 256) 慢约 9%，decode 持平
+        _linear(hidden_state, attn_ctx, layer_prefix + "self_attn.o_proj.weight", nullptr, hidden_state);
 
         // --- MLP Block ---
         // Post-Norm
-        ops::rms_norm(_norm_out, _hidden_state, _weights[layer_prefix + "post_attention_layernorm.weight"], _config.rms_norm_eps);
-
-        // Gate/Up Proj
-        ops::linear(_gate, _norm_out, _weights[layer_prefix + "mlp.gate_proj.weight"], nullptr);
-        ops::linear(_up, _norm_out, _weights[layer_prefix + "mlp.up_proj.weight"], nullptr);
+        ops::rms_norm(norm_out, hidden_state, _weights[layer_prefix + "post_attention_layernorm.weight"], _config.rms_norm_eps);
 
-        // SwiGLU (out -> _gate)
-        ops::swiglu(_gate, _gate, _up);
+        // Gate/Up Proj + SwiGLU (out -> gate)
+        const std::string gate_up = layer_prefix + "mlp.gate_up_proj.weight";
+        ops::linear_swiglu(gate, norm_out, _weights[gate_up], _scale_of(gate_up), _zero_of(gate_up));
 
-        // Down Proj (out -> _hidden_state temp reuse? No, use _attn_out buffer to save memory or _down)
-        // Let's use _attn_out as temp buffer for mlp result
-        ops::linear(_attn_out, _gate, _weights[layer_prefix + "mlp.down_proj.weight"], nullptr);
-
-        // Residual Add
-        ops::add(_hidden_state, _hidden_state, _attn_out);
+        // Down Proj + Residual Add
+        _linear(hidden_state, gate, layer_prefix + "mlp.down_proj.weight", nullptr, hidden_state);
     }
+    rollback.done = true;
+}
 
-    // 3. Final Norm
-    ops::rms_norm(_hidden_state, _hidden_state, _weights["model.norm.weight"], _config.rms_norm_eps);
+void Qwen2Impl::_predict(size_t row, size_t n, int* next_tokens) {
+    if (_logits->shape()[0] < n) {
+        _logits = Tensor::create({n, (size_t)_config.vocab_size}, LLAISYS_DTYPE_F32);
+        _token_out = Tensor::create({n}, LLAISYS_DTYPE_I64);
+    }
+    // 3. Final Norm: 每个序列只有最后一个 token 的输出需要预测下一个 token
+    auto last_hidden = _hidden_state->slice(0, row, row + n);
+    auto last_norm = _norm_out->slice(0, 0, n);
+    ops::rms_norm(last_norm, last_hidden, _weights["model.norm.weight"], _config.rms_norm_eps);
 
-    // 4. LM Head
-    ops::linear(_logits, _hidden_state, _weights["lm_head.weight"], nullptr);
+    // 4. LM Head: n 行一次 GEMM
+    auto logits = _logits->slice(0, 0, n);
+    _linear(logits, last_norm, "lm_head.weight", nullptr);
 
-    // 5. Argmax
-    ops::argmax(_token_out, _prob_out, _logits);
+    // 5. Argmax: 逐行
+    for (size_t i = 0; i < n; ++i) {
+        ops::argmax(_token_out->slice(0, i, i + 1), _prob_out, logits->slice(0, i, i + 1));
+    }
 
-    int64_t result_token;
+    std::vector<int64_t> result_tokens(n);
     // Copy back to host
     llaisys::core::context().runtime().api()->memcpy_sync(
-        reinterpret_cast<std::byte*>(&result_token), 
-        _token_out->data(), 
-        sizeof(int64_t), 
+        reinterpret_cast<std::byte*>(result_tokens.data()),
+        _token_out->data(),
+        n * sizeof(int64_t),
         LLAISYS_MEMCPY_D2H
     );
-
-    return (int)result_token;
+    std::copy(result_tokens.begin(), result_tokens.end(), next_tokens);
 }
 
 } // namespace llaisys  
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 #include "../../tensor/tensor.hpp"
+#include "../kv_cache/paged_kv_cache.hpp"
+#include "../kv_cache/prefix_cache.hpp"
 #include <vector>
 #include <string>
 #include <unordered_map>
@@ -17,6 +19,37 @@ struct Qwen2Config {
     int max_seq_len;
     float rope_theta;
     float rms_norm_eps;
+    // 权重的加载时量化方式 (Qwen2WeightQuant)
+    int weight_quant;
+    // 仅 Q4: 分组大小 (32 的倍数) 与是否使用 zero point
+    int quant_group_size;
+    int quant_zero_point;
+    // prefill 每次前向的最大 token 数，激活缓冲区按它分配; <= 0 时使用 QWEN2_DEFAULT_PREFILL_CHUNK
+    int prefill_chunk_size;
+    // 分页 KV cache 每个 block 的 token 数; <= 0 时使用 QWEN2_DEFAULT_KV_BLOCK_SIZE
+    int kv_block_size;
+    // KV cache 的存储类型: F32/BF16/F16，或 I8 (每个 token 每个 kv head 一个 F32 scale);
+    // LLAISYS_DTYPE_INVALID 时为 F32
+    llaisysDataType_t kv_cache_dtype;
+    // 前缀缓存可保留的 KV 上限 (MB)，从位置 0 开始的请求复用其中最长的已缓存前缀; 0 表示不启用。
+    // 只限制树中持有的 block 数: 淘汰的 block 回到 PagedKVCache 的空闲表供序列复用，并不归还系统，
+    // 进程的 KV 内存上限由 kv_cache_mb 决定
+    int prefix_cache_mb;
+    // KV cache block 池的大小 (MB)，所有序列与前缀缓存共用; 构造时一次分配，之后不扩容也不搬移，
+    // CPU 上物理内存随写入的 token 逐页占用。池满时先淘汰前缀缓存，仍不够则前向抛出 KVCacheFullError。
+    // <= 0 时使用 QWEN2_DEFAULT_KV_CACHE_MB
+    int kv_cache_mb;
+};
+
+// 默认 prefill 分块: 足够让投影层走满 GEMM，激活缓冲区又与 prompt 长度无关
+constexpr int QWEN2_DEFAULT_PREFILL_CHUNK = 256;
+constexpr int QWEN2_DEFAULT_KV_BLOCK_SIZE = 16;
+constexpr int QWEN2_DEFAULT_KV_CACHE_MB = 1024;
+
+enum Qwen2WeightQuant {
+    QWEN2_WEIGHT_QUANT_NONE = 0,
+    QWEN2_WEIGHT_QUANT_INT8 = 1, // 投影层: 每通道对称 INT8 + F32 scale
+    QWEN2_WEIGHT_QUANT_Q4 = 2,   // 投影层、embed_tokens 与 lm_head: 分组 4-bit + F16 scale
 };
 
 class Qwen2Impl {
@@ -24,42 +57,120 @@ public:
     Qwen2Impl(const Qwen2Config& config);
     ~Qwen2Impl() = default;
 
-    void load_tensor(const std::string& name, void* data);
+    // dtype 为 checkpoint 中的原始类型，权重按原样保存，不再转换为 F32
+    void load_tensor(const std::string& name, void* data, llaisysDataType_t dtype);
+    const Qwen2Config& config() const { return _config; }
+
+    // 模型可同时持有多个序列，以调用方给定的 id 区分，它们共享权重与分页 KV cache 的 block 池。
+    // 不带 seq_id 的接口作用于序列 0
     int forward(int token, int pos);
+    // 从位置 pos 开始前向序列 seq_id 的 ntoken 个 token (prompt prefill)，K/V 全部写入 cache，
+    // 返回最后一个 token 之后的预测。按 prefill_chunk_size 分块，每块的投影层以 M = 块长走 GEMM，
+    // 激活缓冲区只需容纳一块，峰值内存与 prompt 长度无关
+    int forward(const int64_t* tokens, size_t ntoken, int pos, int seq_id = 0);
+    // 批量 decode: 第 i 个序列 seq_ids[i] 在位置 positions[i] 前向一个 token tokens[i]，
+    // 预测写入 next_tokens[i]。各投影层对 n 个序列做一次 M = n 的 GEMM (权重只读一遍)，
+    // attention 按序列分别读取各自的 KV。seq_ids 互不相同，不存在的序列从空序列开始。
+    // 池中 block 不足时抛出 KVCacheFullError，所有序列停在各自的 positions[i]
+    void forward_batch(const int* seq_ids, const int64_t* tokens, const int* positions, size_t n, int* next_tokens);
+    // 结束序列 seq_id 并释放其 block (写满的 block 先交给前缀缓存)
+    void release_sequence(int seq_id);
+    // KV block 池的用量，供调度器决定接纳与抢占: ntoken 个 token 占用的 block 数、池的 block 总数，
+    // 以及可用的 block 数 (空闲不足 wanted 个时先淘汰前缀缓存)
+    size_t kv_blocks_for(size_t ntoken) const;
+    size_t kv_total_blocks() const { return _kv_cache->numBlocks(); }
+    size_t kv_available_blocks(size_t wanted) { return _kv_cache->reclaim(wanted); }
+    // 前缀缓存的命中统计，未启用时全为 0
+    PrefixCacheStats prefix_cache_stats() const;
+    // 把序列 seq_id 的 token 与 KV 写入会话文件 (见 kv_session.hpp)
+    void save_session(const std::string& path, int seq_id = 0) const;
+    // 用会话文件替换序列 seq_id 并返回其 token，之后从位置 token 数继续 forward。
+    // 文件经内存映射直接拷入 cache 的 block，不做任何前向; 文件无法读取、模型配置或 KV 布局不符时
+    // 抛出异常，序列 seq_id 保持原样
+    std::vector<int64_t> load_session(const std::string& path, int seq_id = 0);
 
 private:
     Qwen2Config _config;
     
     // Weights map: name -> tensor
     std::unordered_map<std::string, tensor_t> _weights;
+    // 量化权重的 scale / zero point: weight name -> tensor (见 ops::quantize)
+    std::unordered_map<std::string, tensor_t> _weight_scales;
+    std::unordered_map<std::string, tensor_t> _weight_zeros;
     
-    // KV Cache: [layer_idx] -> {K_cache, V_cache}
-    // Shape: [max_seq_len, n_kv_heads, head_dim]
-    std::vector<std::pair<tensor_t, tensor_t>> _kv_cache;
+    // 一个序列的 KV 在 cache 中的位置及其已写入 KV 的 token (作为前缀缓存的键)
+    struct Sequence {
+        KVSequence kv;
+        std::vector<int64_t> tokens;
+    };
+    // 一次前向中属于同一序列的连续 n 行，第一行位于位置 pos
+    struct Segment {
+        Sequence* seq;
+        size_t row;
+        size_t n;
+        size_t pos;
+    };
+
+    // 分页 KV Cache: 按实际 token 数分配 block，各序列经自己的 block table 访问
+    std::unique_ptr<PagedKVCache> _kv_cache;
+    std::unordered_map<int, Sequence> _sequences;
+    // 前缀缓存: 序列被回退或被新请求替换前，其写满的 block 留在树中供之后的请求复用
+    std::unique_ptr<PrefixCache> _prefix_cache;
+    size_t _max_blocks = 0;     // 一个序列最多的 block 数 ceil(max_seq_len / block_size)
+
+    // RoPE 的 cos/sin 表 [max_seq_len, 2, head_dim / 2]，构造时按 rope_theta 算一次，各层的 q/k 直接查表
+    tensor_t _rope_table;
 
     // Intermediate tensors (Pre-allocated for performance)
-    tensor_t _input_embed;  // [1, 1, hidden]
-    tensor_t _hidden_state; // [1, 1, hidden]
-    tensor_t _norm_out;     // [1, 1, hidden]
+    // 按 token 数分配 [_capacity, ...] (最多一个 prefill 块)，每块取前 n 行的视图
+    size_t _capacity = 0;
+    tensor_t _token_ids;    // [cap]
+    tensor_t _block_tables; // [cap, _max_blocks] I32, 第 i 段的 block table 在第 i 行，每次前向前从序列同步
+    tensor_t _hidden_state; // [cap, hidden]
+    tensor_t _norm_out;     // [cap, hidden]
     
     // Attention intermediates
-    tensor_t _q, _k, _v;    // [1, n_head, head_dim] / [1, n_kv_head, head_dim]
-    tensor_t _attn_ctx; 
-    tensor_t _attn_out;     // [1, 1, hidden]
+    tensor_t _qkv;          // [cap, (n_head + 2 * n_kv_head) * head_dim], 融合 QKV 投影的输出
+    tensor_t _q;            // [cap, n_head, head_dim], 旋转后的 q
+    tensor_t _attn_ctx;     // [cap, hidden]
     
     // MLP intermediates
-    tensor_t _gate, _up, _down; // [1, 1, intermediate]
+    tensor_t _gate;         // [cap, intermediate], 融合 gate/up + SwiGLU 的输出
     
-    // Logits
-    tensor_t _logits;       // [1, 1, vocab_size]
+    // Logits: 每个序列只算最后一个 token，批量 decode 时按批大小扩容
+    tensor_t _logits;       // [batch, vocab_size]
     tensor_t _prob_out;     // [1]
-    tensor_t _token_out;    // [1]
-    
-    // Helpers
-    tensor_t _pos_ids;      // [1]
+    tensor_t _token_out;    // [batch]
+
+    // 所有权重加载完成后 (首次 forward 时) 执行一次: 共享词表、拼接 QKV / gate-up、预打包
+    bool _weights_ready = false;
 
     void _init_params();
+    // 确保激活缓冲区至少能容纳 ntoken 个 token
+    void _reserve(size_t ntoken);
+    size_t _chunk_size() const;
+    // 把序列 seq_id 回退到 pos 个 token (不存在时新建)，pos 之后的 KV 作废
+    Sequence& _rewind(int seq_id, size_t pos);
+    // 前向 tokens 中的各段 (段的行连续且依次排列)，K/V 写入各自序列的 cache，各行输出留在 _hidden_state。
+    // 抛出异常时每段的序列都退回 segment.pos
+    void _forward_rows(const int64_t* tokens, const std::vector<Segment>& segments);
+    // 对 _hidden_state 的 [row, row + n) 行做 final norm + lm_head + argmax，预测写入 next_tokens
+    void _predict(size_t row, size_t n, int* next_tokens);
     void _init_kv_cache();
+    // 决定 KV 内容的配置项的哈希，写入会话文件以拒绝其他模型保存的会话
+    uint64_t _config_hash() const;
+    void _finalize_weights();
+    // 把每层的 q/k/v_proj 权重、bias 及量化参数按行拼接为 self_attn.qkv_proj.*
+    void _fuse_qkv(const std::string& layer_prefix);
+    // 把每层的 gate_proj / up_proj 按行交错为 mlp.gate_up_proj.weight (见 ops::linear_swiglu)
+    void _fuse_gate_up(const std::string& layer_prefix);
+    // 把投影层与 lm_head 的权重预打包为 linear 内核的 panel 格式 (见 ops::linear_pack_weight)
+    void _pack_weights();
+    // 量化权重的 scale / zero point，浮点权重返回 nullptr
+    tensor_t _scale_of(const std::string& weight_name) const;
+    tensor_t _zero_of(const std::string& weight_name) const;
+    // 对按名称查找的投影权重做 linear，量化权重自动带上 scale; residual 非空时结果累加到其上
+    void _linear(tensor_t out, tensor_t in, const std::string& weight_name, tensor_t bias, tensor_t residual = nullptr);
 };
 
 } // namespace llaisys
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include "qwen2_scheduler.hpp"
+#include "../../utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace llaisys {
+
+Qwen2Scheduler::Qwen2Scheduler(Qwen2Impl& model, const Qwen2SchedulerConfig& config) : _model(model) {
+    const Qwen2Config& model_config = model.config();
+    _max_batch = config.max_batch > 0 ? (size_t)config.max_batch : (size_t)QWEN2_DEFAULT_MAX_BATCH;
+    if (config.prefill_budget > 0) {
+        _prefill_budget = (size_t)config.prefill_budget;
+    } else {
+        _prefill_budget = model_config.prefill_chunk_size > 0 ? (size_t)model_config.prefill_chunk_size
+                                                              : (size_t)QWEN2_DEFAULT_PREFILL_CHUNK;
+    }
+    _max_seq_len = (size_t)model_config.max_seq_len;
+    // 空位即模型中的序列 id
+    for (int slot = (int)_max_batch - 1; slot >= 0; --slot) {
+        _free_slots.push_back(slot);
+    }
+    _worker = std::thread(&Qwen2Scheduler::_loop, this);
+}
+
+Qwen2Scheduler::~Qwen2Scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _work_cv.notify_all();
+    _worker.join();
+}
+
+int64_t Qwen2Scheduler::submit(const int64_t* prompt, size_t ntoken, size_t max_new_tokens, int64_t eos_token) {
+    CHECK_ARGUMENT(ntoken > 0, "Qwen2Scheduler: empty prompt");
+    CHECK_ARGUMENT(ntoken < _max_seq_len, "Qwen2Scheduler: prompt exceeds max_seq_len");
+    CHECK_ARGUMENT(max_new_tokens > 0, "Qwen2Scheduler: max_new_tokens must be positive");
+    auto request = std::make_shared<Request>();
+    request->context.assign(prompt, prompt + ntoken);
+    request->max_new_tokens = max_new_tokens;
+    request->eos_token = eos_token;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        request->id = _next_id++;
+        _requests[request->id] = request;
+        _waiting.push_back(request);
+    }
+    _work_cv.notify_one();
+    return request->id;
+}
+
+int Qwen2Scheduler::poll(int64_t id, int64_t* tokens, size_t capacity, int timeout_ms, bool* finished, bool* failed) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto it = _requests.find(id);
+    if (it == _requests.end()) {
+        return -1;
+    }
+    request_t request = it->second;
+    auto ready = [&request] { return !request->output.empty() || request->finished; };
+    if (timeout_ms < 0) {
+        _output_cv.wait(lock, ready);
+    } else if (timeout_ms > 0) {
+        _output_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready);
+    }
+
+    size_t n = std::min(capacity, request->output.size());
+    std::copy_n(request->output.begin(), n, tokens);
+    request->output.erase(request->output.begin(), request->output.begin() + n);
+    *finished = request->finished && request->output.empty();
+    *failed = request->failed;
+    if (*finished) {
+        _requests.erase(id);
+    }
+    return (int)n;
+}
+
+void Qwen2Scheduler::cancel(int64_t id) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _requests.find(id);
+    if (it == _requests.end()) {
+        return;
+    }
+    // 等待中的请求直接移出队列，运行中的由工作线程在下一步退出批次
+    it->second->cancelled = true;
+    _waiting.erase(std::remove(_waiting.begin(), _waiting.end(), it->second), _waiting.end());
+    _requests.erase(it);
+}
+
+void Qwen2Scheduler::_loop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _work_cv.wait(lock, [this] { return _stop || !_waiting.empty() || !_running.empty(); });
+            if (_stop) {
+                break;
+            }
+            for (auto& r : _running) {
+                r->done = r->done || r->cancelled;
+            }
+            _admit();
+        }
+        try {
+            _step();
+        } catch (const std::exception& e) {
+            // _step 已按请求处理前向的错误，到这里的只能结束整个批次
+            std::cerr << "[ERROR] Qwen2Scheduler: " << e.what() << std::endl;
+            for (auto& r : _running) {
+                r->error = r->error || !r->done;
+                r->done = true;
+            }
+        }
+        _publish();
+    }
+    for (auto& r : _running) {
+        _model.release_sequence(r->slot);
+    }
+    _running.clear();
+}
+
+void Qwen2Scheduler::_admit() {
+    // 正在 prefill 的请求还要的 block 先算作已占用
+    size_t reserved = 0;
+    for (const auto& r : _running) {
+        if (!r->done && r->prefilled < r->context.size()) {
+            reserved += _model.kv_blocks_for(r->context.size()) + 1 - _model.kv_blocks_for(r->prefilled);
+        }
+    }
+    // 按提交顺序接纳: 每一步都可以加入，不必等当前批次结束; 队首放不下时后面的也等待
+    while (!_waiting.empty() && !_free_slots.empty()) {
+        request_t r = _waiting.front();
+        size_t need = _model.kv_blocks_for(r->context.size()) + 1;
+        if (need > _model.kv_total_blocks()) {
+            // 整个池都放不下，等下去也不会有结果
+            std::cerr << "[ERROR] Qwen2Scheduler: request " << r->id << " needs " << need
+                      << " KV blocks, the pool has " << _model.kv_total_blocks() << std::endl;
+            _waiting.pop_front();
+            r->finished = true;
+            r->failed = true;
+            _output_cv.notify_all();
+            continue;
+        }
+        if (_model.kv_available_blocks(reserved + need) < reserved + need) {
+            break;
+        }
+        reserved += need;
+        _waiting.pop_front();
+        r->slot = _free_slots.back();
+        _free_slots.pop_back();
+        r->prefilled = 0;
+        _running.push_back(r);
+    }
+}
+
+void Qwen2Scheduler::_step() {
+    // 1. Prefill: 按接纳顺序把本步的 token 预算分给 context 还没写完的请求;
+    //    只有本步开始前已写完的请求参与 decode。被换出的总是位于当前请求之后 (或就是当前请求)
+    std::vector<Request*> batch;
+    size_t budget = _prefill_budget;
+    for (size_t i = 0; i < _running.size(); ++i) {
+        Request& r = *_running[i];
+        if (r.done) {
+            continue;
+        }
+        if (r.prefilled == r.context.size()) {
+            batch.push_back(&r);
+            continue;
+        }
+        if (budget == 0) {
+            continue;
+        }
+        size_t n = std::min(budget, r.context.size() - r.prefilled);
+        int token = -1;
+        bool preempted = false;
+        try {
+            while (true) {
+                try {
+                    token = _model.forward(r.context.data() + r.prefilled, n, (int)r.prefilled, r.slot);
+                    break;
+                } catch (const KVCacheFullError&) {
+                    if (_preempt() == &r) {
+                        preempted = true;
+                        break;
+                    }
+                }
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] Qwen2Scheduler: request " << r.id << ": " << e.what() << std::endl;
+            r.error = true;
+            r.done = true;
+            continue;
+        }
+        if (preempted) {
+            break;
+        }
+        r.prefilled += n;
+        budget -= n;
+        // prompt 写完时得到第一个 token，下一步起参与 decode; 换出后重新 prefill 的请求已有 last_token
+        if (r.prefilled == r.context.size() && r.generated == 0) {
+            _emit(r, token);
+        }
+    }
+
+    // 2. Decode: 已完成 prefill 的请求各前向上一步生成的 token，投影层一次 GEMM
+    while (!batch.empty()) {
+        std::vector<int> seq_ids, positions;
+        std::vector<int64_t> tokens;
+        for (Request* r : batch) {
+            seq_ids.push_back(r->slot);
+            tokens.push_back(r->last_token);
+            positions.push_back((int)r->context.size());
+        }
+        std::vector<int> next_tokens(batch.size());
+        try {
+            _model.forward_batch(seq_ids.data(), tokens.data(), positions.data(), batch.size(), next_tokens.data());
+        } catch (const KVCacheFullError&) {
+            // forward_batch 失败时所有序列保持原长度，换出一个请求后重试
+            Request* victim = _preempt();
+            batch.erase(std::remove(batch.begin(), batch.end(), victim), batch.end());
+            continue;
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] Qwen2Scheduler: forward_batch: " << e.what() << std::endl;
+            for (Request* r : batch) {
+                r->error = true;
+                r->done = true;
+            }
+            break;
+        }
+        for (size_t i = 0; i < batch.size(); ++i) {
+            batch[i]->context.push_back(batch[i]->last_token);
+            batch[i]->prefilled += 1;
+            _emit(*batch[i], next_tokens[i]);
+        }
+        break;
+    }
+}
+
+void Qwen2Scheduler::_emit(Request& r, int token) {
+    r.fresh.push_back(token);
+    r.last_token = token;
+    r.generated += 1;
+    // 下一次 decode 位于 context.size()，必须小于 max_seq_len
+    r.done = r.generated >= r.max_new_tokens || (r.eos_token >= 0 && token == r.eos_token) ||
+             r.context.size() >= _max_seq_len;
+}
+
+Qwen2Scheduler::Request* Qwen2Scheduler::_preempt() {
+    auto it = std::find_if(_running.rbegin(), _running.rend(), [](const request_t& r) { return !r->done; });
+    ASSERT(it != _running.rend(), "Qwen2Scheduler: no request to preempt");
+    request_t r = *it;
+    _running.erase(std::next(it).base());
+    // 写满的 block 进入前缀缓存，重新 prefill 时可能直接命中
+    _model.release_sequence(r->slot);
+    _free_slots.push_back(r->slot);
+    r->slot = -1;
+    r->prefilled = 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        r->output.insert(r->output.end(), r->fresh.begin(), r->fresh.end());
+        if (!r->cancelled) {
+            _waiting.push_front(r);
+        }
+    }
+    r->fresh.clear();
+    _output_cv.notify_all();
+    return r.get();
+}
+
+void Qwen2Scheduler::_publish() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto& r : _running) {
+            r->output.insert(r->output.end(), r->fresh.begin(), r->fresh.end());
+            r->fresh.clear();
+            r->finished = r->done;
+            r->failed = r->error;
+        }
+    }
+    _output_cv.notify_all();
+
+    // 结束的请求退出批次，序列交还模型 (写满的 block 进入前缀缓存)
+    auto it = std::stable_partition(_running.begin(), _running.end(), [](const request_t& r) { return !r->done; });
+    for (auto done = it; done != _running.end(); ++done) {
+        _model.release_sequence((*done)->slot);
+        _free_slots.push_back((*done)->slot);
+    }
+    _running.erase(it, _running.end());
+}
+
+} // namespace llaisys
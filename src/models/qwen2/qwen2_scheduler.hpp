@@ -0,0 +1,107 @@
+#pragma once
+#include "qwen2_impl.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace llaisys {
+
+struct Qwen2SchedulerConfig {
+    // 同时运行 (prefill 或 decode) 的最多请求数; <= 0 时使用 QWEN2_DEFAULT_MAX_BATCH
+    int max_batch;
+    // 每步最多 prefill 的 prompt token 数，长 prompt 按它分块与 decode 交错，
+    // 限制新请求进入时正在生成的请求多等的时间; <= 0 时使用模型的 prefill_chunk_size
+    int prefill_budget;
+};
+
+constexpr int QWEN2_DEFAULT_MAX_BATCH = 64;
+
+// 连续批处理调度器: 多个请求共享一个 Qwen2Impl (一份权重、一个 KV block 池)。
+// 工作线程每一步先按提交顺序接纳等待中的请求 (需有空位，且 KV 池的可用 block 在扣除
+// 正在 prefill 的请求还要的部分后，能容纳其 prompt 再加一个 block)，按预算 prefill 一块 prompt，
+// 再对所有已完成 prefill 的请求做一次 forward_batch，结束的请求立即退出批次并释放序列。
+// 前向拿不到 block 时换出最新接纳的请求: 释放其序列并放回队首，重新接纳后 prefill
+// prompt 与已生成的 token 再继续生成。前向出错只结束该次前向涉及的请求。
+// 调度器存在期间模型只能由它使用; 采样为 greedy。KV 池的大小见 Qwen2Config::kv_cache_mb。
+class Qwen2Scheduler {
+public:
+    Qwen2Scheduler(Qwen2Impl& model, const Qwen2SchedulerConfig& config);
+    // 停止工作线程，未结束的请求被丢弃
+    ~Qwen2Scheduler();
+
+    Qwen2Scheduler(const Qwen2Scheduler&) = delete;
+    Qwen2Scheduler& operator=(const Qwen2Scheduler&) = delete;
+
+    // 提交请求并返回其 id。生成 max_new_tokens 个 token、生成 eos_token (>= 0 时，包含在输出中)
+    // 或序列达到 max_seq_len 时结束
+    int64_t submit(const int64_t* prompt, size_t ntoken, size_t max_new_tokens, int64_t eos_token);
+    // 取出请求 id 自上次 poll 以来生成的 token (最多 capacity 个)，返回取出的个数。
+    // 没有新 token 时最多等待 timeout_ms 毫秒 (0 不等待，< 0 一直等)。
+    // *finished 表示请求已结束且 token 已全部取出，此后 id 失效; *failed 表示请求因错误中止
+    // (此前生成的 token 照常取出)。id 不存在时返回 -1
+    int poll(int64_t id, int64_t* tokens, size_t capacity, int timeout_ms, bool* finished, bool* failed);
+    // 取消请求，其 id 立即失效
+    void cancel(int64_t id);
+
+private:
+    struct Request {
+        int64_t id;
+        // 应写入 KV 的 token: prompt 加上已前向的生成 token，被换出后据此重新 prefill
+        std::vector<int64_t> context;
+        size_t max_new_tokens;
+        int64_t eos_token;
+        // 以下由工作线程独占
+        int slot = -1;           // 运行中时使用的模型序列 id
+        size_t prefilled = 0;    // context 中已写入 KV 的 token 数
+        size_t generated = 0;    // 已生成的 token 数
+        int64_t last_token = -1; // 最近生成、尚未前向的 token
+        std::vector<int64_t> fresh; // 本步生成、尚未发布的 token
+        bool done = false;
+        bool error = false;
+        // 以下受 _mutex 保护
+        std::vector<int64_t> output; // 已发布、尚未被 poll 取走的 token
+        bool finished = false;
+        bool failed = false;
+        bool cancelled = false;
+    };
+    using request_t = std::shared_ptr<Request>;
+
+    Qwen2Impl& _model;
+    size_t _max_batch;
+    size_t _prefill_budget;
+    size_t _max_seq_len;
+
+    std::mutex _mutex;
+    std::condition_variable _work_cv;   // 有新请求或需要停止
+    std::condition_variable _output_cv; // 有请求产生了 token 或结束
+    std::unordered_map<int64_t, request_t> _requests;
+    std::deque<request_t> _waiting;
+    int64_t _next_id = 0;
+    bool _stop = false;
+
+    // 工作线程独占
+    std::vector<request_t> _running;
+    std::vector<int> _free_slots;
+
+    std::thread _worker;
+
+    void _loop();
+    // 接纳等待中的请求，调用时持有 _mutex
+    void _admit();
+    // 一步 prefill + batched decode
+    void _step();
+    // 记录 r 生成的 token 并判断是否结束
+    void _emit(Request& r, int token);
+    // 换出最新接纳、尚未结束的请求: 释放其序列与空位并放回队首，返回该请求
+    Request* _preempt();
+    // 把本步的 token 与结束状态发布给 poll，并让结束的请求退出批次
+    void _publish();
+};
+
+} // namespace llaisys
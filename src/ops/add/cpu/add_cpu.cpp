@@ -1,18 +1,21 @@
 #include "add_cpu.hpp"
 
+#include "../../../core/thread_pool/thread_pool.hpp"
 #include "../../../utils.hpp"
 
 #include <cmath>
 
 template <typename T>
 void add_(T *c, const T *a, const T *b, size_t numel) {
-    for (size_t i = 0; i < numel; i++) {
-        if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-            c[i] = llaisys::utils::cast<T>(llaisys::utils::cast<float>(a[i]) + llaisys::utils::cast<float>(b[i]));
-        } else {
-            c[i] = a[i] + b[i];
+    llaisys::core::parallel_for(numel, 8192, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
+                c[i] = llaisys::utils::cast<T>(llaisys::utils::cast<float>(a[i]) + llaisys::utils::cast<float>(b[i]));
+            } else {
+                c[i] = a[i] + b[i];
+            }
         }
-    }
+    });
 }
 
 namespace llaisys::ops::cpu {
@@ -0,0 +1,105 @@
+#include "add_rms_norm_cpu.hpp"
+
+#include "../../../core/thread_pool/thread_pool.hpp"
+#include "../../../utils.hpp"
+#include "../../../utils/simd.hpp"
+
+#include <cmath>
+#include <type_traits>
+
+namespace {
+namespace simd = llaisys::utils::simd;
+
+// Stores one vector into T, rounding each lane.
+template <typename T>
+void store(T *p, simd::vfloat v) {
+    if constexpr (std::is_same_v<T, float>) {
+        simd::store(p, v);
+    } else {
+        float lanes[simd::width];
+        simd::store(lanes, v);
+        for (size_t k = 0; k < simd::width; k++) {
+            p[k] = llaisys::utils::cast<T>(lanes[k]);
+        }
+    }
+}
+
+template <typename T, typename W>
+void add_rms_norm_row(T *out, T *residual, const T *in, const W *weight, float eps, size_t dim) {
+    // Pass 1: residual += in, accumulating the squares of the stored (rounded) sums.
+    simd::vfloat acc = simd::zero();
+    size_t j = 0;
+    for (; j + simd::width <= dim; j += simd::width) {
+        simd::vfloat r = simd::add(simd::load(residual + j), simd::load(in + j));
+        store(residual + j, r);
+        if constexpr (!std::is_same_v<T, float>) {
+            r = simd::load(residual + j);
+        }
+        acc = simd::fmadd(r, r, acc);
+    }
+    float sum_sq = simd::reduce_add(acc);
+    for (; j < dim; j++) {
+        residual[j] =
+            llaisys::utils::cast<T>(llaisys::utils::cast<float>(residual[j]) + llaisys::utils::cast<float>(in[j]));
+        float r = llaisys::utils::cast<float>(residual[j]);
+        sum_sq += r * r;
+    }
+
+    // Pass 2: the row is still in cache.
+    const float inv_rms = 1.0f / std::sqrt(sum_sq / dim + eps);
+    const simd::vfloat scale = simd::set1(inv_rms);
+    j = 0;
+    for (; j + simd::width <= dim; j += simd::width) {
+        store(out + j, simd::mul(simd::mul(simd::load(residual + j), scale), simd::load(weight + j)));
+    }
+    for (; j < dim; j++) {
+        out[j] = llaisys::utils::cast<T>(llaisys::utils::cast<float>(residual[j]) * inv_rms *
+                                         llaisys::utils::cast<float>(weight[j]));
+    }
+}
+
+template <typename T, typename W>
+void add_rms_norm_(T *out, T *residual, const T *in, const W *weight, float eps, size_t num_rows, size_t dim) {
+    llaisys::core::parallel_for(num_rows, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            add_rms_norm_row(out + i * dim, residual + i * dim, in + i * dim, weight, eps, dim);
+        }
+    });
+}
+
+template <typename T>
+void add_rms_norm_to(std::byte *out, std::byte *residual, const std::byte *in, const std::byte *weight,
+                     llaisysDataType_t weight_type, float eps, size_t num_rows, size_t dim) {
+    T *out_ = reinterpret_cast<T *>(out);
+    T *residual_ = reinterpret_cast<T *>(residual);
+    const T *in_ = reinterpret_cast<const T *>(in);
+    switch (weight_type) {
+    case LLAISYS_DTYPE_F32:
+        return add_rms_norm_(out_, residual_, in_, reinterpret_cast<const float *>(weight), eps, num_rows, dim);
+    case LLAISYS_DTYPE_BF16:
+        return add_rms_norm_(out_, residual_, in_, reinterpret_cast<const llaisys::bf16_t *>(weight), eps, num_rows,
+                             dim);
+    case LLAISYS_DTYPE_F16:
+        return add_rms_norm_(out_, residual_, in_, reinterpret_cast<const llaisys::fp16_t *>(weight), eps, num_rows,
+                             dim);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(weight_type);
+    }
+}
+} // namespace
+
+namespace llaisys::ops::cpu {
+void add_rms_norm(std::byte *out, std::byte *residual, const std::byte *in, const std::byte *weight,
+                  llaisysDataType_t type, llaisysDataType_t weight_type, float eps, size_t num_rows, size_t dim) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return add_rms_norm_to<float>(out, residual, in, weight, weight_type, eps, num_rows, dim);
+    case LLAISYS_DTYPE_BF16:
+        return add_rms_norm_to<bf16_t>(out, residual, in, weight, weight_type, eps, num_rows, dim);
+    case LLAISYS_DTYPE_F16:
+        return add_rms_norm_to<fp16_t>(out, residual, in, weight, weight_type, eps, num_rows, dim);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+} // namespace llaisys::ops::cpu
@@ -0,0 +1,12 @@
+#pragma once
+#include "llaisys.h"
+
+#include <cstddef>
+
+namespace llaisys::ops::cpu {
+// For each of num_rows rows of dim values: residual += in, then out = residual / rms(residual) * weight,
+// with rms(x) = sqrt(mean(x^2) + eps). The norm is taken over residual as stored, i.e. after rounding
+// to `type`. out, residual and in are `type`, weight is `weight_type`; out may alias in.
+void add_rms_norm(std::byte *out, std::byte *residual, const std::byte *in, const std::byte *weight,
+                  llaisysDataType_t type, llaisysDataType_t weight_type, float eps, size_t num_rows, size_t dim);
+}
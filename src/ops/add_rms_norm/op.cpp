@@ -0,0 +1,29 @@
+#include "op.hpp"
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+#include "cpu/add_rms_norm_cpu.hpp"
+
+namespace llaisys::ops {
+void add_rms_norm(tensor_t out, tensor_t residual, tensor_t in, tensor_t weight, float eps) {
+    CHECK_SAME_DEVICE(out, residual, in);
+    CHECK_SAME_DEVICE(out, weight);
+    CHECK_SAME_DTYPE(out->dtype(), residual->dtype(), in->dtype());
+    CHECK_SAME_SHAPE(out->shape(), residual->shape(), in->shape());
+    ASSERT(out->isContiguous() && residual->isContiguous() && in->isContiguous() && weight->isContiguous(),
+           "AddRmsNorm: all tensors must be contiguous.");
+
+    // [rows, dim]: 行之间并行，prefill 的多行一次调用
+    size_t dim = in->shape().back();
+    size_t num_rows = in->numel() / dim;
+    ASSERT(weight->numel() == dim, "AddRmsNorm: weight size must match the last dim of input");
+
+    llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
+
+    if (out->deviceType() == LLAISYS_DEVICE_CPU) {
+        return cpu::add_rms_norm(out->data(), residual->data(), in->data(), weight->data(), out->dtype(),
+                                 weight->dtype(), eps, num_rows, dim);
+    } else {
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+} // namespace llaisys::ops
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "../../tensor/tensor.hpp"
+
+namespace llaisys::ops {
+// 残差相加与 RMSNorm 融合: residual += in，out = rms_norm(residual) * weight，每行一遍完成。
+// out/residual/in: [rows, dim] 连续且同 dtype，out 可以就是 in; weight: [dim]，dtype 可以与激活不同。
+// 结果与先 add 再 rms_norm 一致 (范数基于已按激活 dtype 舍入的 residual)
+// 投影之后的残差相加可以直接交给 linear 的 residual 参数，Qwen2 因此不使用本算子
+void add_rms_norm(tensor_t out, tensor_t residual, tensor_t in, tensor_t weight, float eps);
+}
@@ -1,6 +1,8 @@
 #pragma once
+#include "../../../core/thread_pool/thread_pool.hpp"
 #include "../../../utils.hpp"
 #include <limits>
+#include <utility>
 
 namespace llaisys::ops::cpu {
 
@@ -10,19 +12,26 @@ void argmax(void *max_idx_ptr, void *max_val_ptr, const void *vals_ptr, size_t n
     auto *max_val = reinterpret_cast<T *>(max_val_ptr);
     const auto *vals = reinterpret_cast<const T *>(vals_ptr);
 
-    float current_max = -std::numeric_limits<float>::infinity();
-    int64_t current_idx = 0;
+    using Best = std::pair<float, int64_t>;
+    const Best none{-std::numeric_limits<float>::infinity(), 0};
 
-    for (size_t i = 0; i < numel; ++i) {
-        float val = utils::cast<float>(vals[i]);
-        if (val > current_max) {
-            current_max = val;
-            current_idx = i;
-        }
-    }
+    // 各块内取第一个最大值，再按块顺序合并，保证结果与线程数无关
+    Best best = core::parallel_reduce(
+        numel, 16384, none,
+        [&](size_t begin, size_t end) {
+            Best local = none;
+            for (size_t i = begin; i < end; ++i) {
+                float val = utils::cast<float>(vals[i]);
+                if (val > local.first) {
+                    local = {val, static_cast<int64_t>(i)};
+                }
+            }
+            return local;
+        },
+        [](const Best &a, const Best &b) { return b.first > a.first ? b : a; });
 
-    *max_idx = current_idx;
-    *max_val = utils::cast<T>(current_max);
+    *max_idx = best.second;
+    *max_val = utils::cast<T>(best.first);
 }
 
 } // namespace llaisys::ops::cpu
\ No newline at end of file
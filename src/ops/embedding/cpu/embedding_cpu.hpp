@@ -1,28 +1,78 @@
 #pragma once
 #include <cstring>
+#include <type_traits>
+#include "../../../core/thread_pool/thread_pool.hpp"
 #include "../../../utils.hpp"
+#include "../../quantize/cpu/quantize_cpu.hpp"
 
 namespace llaisys::ops::cpu {
 
-template <typename T>
+// 输出为 T，词表为 W；类型不同时逐元素转换
+template <typename T, typename W = T>
 void embedding(void *out_ptr, const void *index_ptr, const void *weight_ptr, 
                size_t seq_len, size_t hidden_dim, size_t vocab_size) {
     auto *out = reinterpret_cast<T *>(out_ptr);
     const auto *index = reinterpret_cast<const int64_t *>(index_ptr);
-    const auto *weight = reinterpret_cast<const T *>(weight_ptr);
+    const auto *weight = reinterpret_cast<const W *>(weight_ptr);
 
-    for (size_t i = 0; i < seq_len; ++i) {
-        int64_t idx = index[i];
-        if (idx < 0 || static_cast<size_t>(idx) >= vocab_size) {
-            continue; 
-        }
+    core::parallel_for(seq_len, 8, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            int64_t idx = index[i];
+            if (idx < 0 || static_cast<size_t>(idx) >= vocab_size) {
+                continue;
+            }
         
-        // weight shape: [vocab_size, hidden_dim]
-        const T* src_row = weight + idx * hidden_dim;
-        T* dst_row = out + i * hidden_dim;
+            // weight shape: [vocab_size, hidden_dim]
+            const W* src_row = weight + idx * hidden_dim;
+            T* dst_row = out + i * hidden_dim;
         
-        std::memcpy(dst_row, src_row, hidden_dim * sizeof(T));
-    }
+            if constexpr (std::is_same_v<T, W>) {
+                std::memcpy(dst_row, src_row, hidden_dim * sizeof(T));
+            } else {
+                for (size_t j = 0; j < hidden_dim; ++j) {
+                    dst_row[j] = utils::cast<T>(utils::cast<float>(src_row[j]));
+                }
+            }
+        }
+    });
+}
+
+// 量化词表: 按行反量化
+// I8: weight [vocab, hidden], scale [vocab] F32
+// q4: weight [vocab, hidden / 2], scale [vocab, hidden / group] F16, zero 可选
+template <typename T>
+void embedding_quantized(void *out_ptr, const void *index_ptr, const void *weight_ptr, const void *scale_ptr,
+                         const void *zero_ptr, llaisysDataType_t weight_type, size_t group,
+                         size_t seq_len, size_t hidden_dim, size_t vocab_size) {
+    auto *out = reinterpret_cast<T *>(out_ptr);
+    const auto *index = reinterpret_cast<const int64_t *>(index_ptr);
+    const auto *zero = reinterpret_cast<const uint8_t *>(zero_ptr);
+
+    core::parallel_for(seq_len, 8, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            int64_t idx = index[i];
+            if (idx < 0 || static_cast<size_t>(idx) >= vocab_size) {
+                continue;
+            }
+            T* dst_row = out + i * hidden_dim;
+
+            if (weight_type == LLAISYS_DTYPE_I8) {
+                const auto *src_row = reinterpret_cast<const int8_t *>(weight_ptr) + idx * hidden_dim;
+                float s = reinterpret_cast<const float *>(scale_ptr)[idx];
+                for (size_t j = 0; j < hidden_dim; ++j) {
+                    dst_row[j] = utils::cast<T>(src_row[j] * s);
+                }
+            } else {
+                const auto *src_row = reinterpret_cast<const uint8_t *>(weight_ptr) + idx * (hidden_dim / 2);
+                const auto *scale = reinterpret_cast<const fp16_t *>(scale_ptr) + idx * (hidden_dim / group);
+                for (size_t j = 0; j < hidden_dim; ++j) {
+                    size_t g = j / group;
+                    float z = zero ? zero[idx * (hidden_dim / group) + g] : Q4_SYMMETRIC_ZERO;
+                    dst_row[j] = utils::cast<T>((q4_get(src_row, j) - z) * utils::cast<float>(scale[g]));
+                }
+            }
+        }
+    });
 }
 
 } // namespace llaisys::ops::cpu
\ No newline at end of file
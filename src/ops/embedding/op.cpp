@@ -2,26 +2,76 @@
 #include "../../core/llaisys_core.hpp"
 #include "../../utils.hpp"
 #include "cpu/embedding_cpu.hpp"
+#include "../quantize/op.hpp"
 
 namespace llaisys::ops {
-void embedding(tensor_t out, tensor_t index, tensor_t weight) {
+namespace {
+template <typename T>
+void embedding_cpu(tensor_t out, tensor_t index, tensor_t weight, size_t seq_len, size_t hidden_dim, size_t vocab_size) {
+    switch (weight->dtype()) {
+    case LLAISYS_DTYPE_F32:
+        return cpu::embedding<T, float>(out->data(), index->data(), weight->data(), seq_len, hidden_dim, vocab_size);
+    case LLAISYS_DTYPE_F16:
+        return cpu::embedding<T, fp16_t>(out->data(), index->data(), weight->data(), seq_len, hidden_dim, vocab_size);
+    case LLAISYS_DTYPE_BF16:
+        return cpu::embedding<T, bf16_t>(out->data(), index->data(), weight->data(), seq_len, hidden_dim, vocab_size);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(weight->dtype());
+    }
+}
+} // namespace
+
+void embedding(tensor_t out, tensor_t index, tensor_t weight, tensor_t weight_scale, tensor_t weight_zero) {
     CHECK_SAME_DEVICE(out, index, weight);
     ASSERT(index->dtype() == LLAISYS_DTYPE_I64, "Embedding: index must be I64");
     
     size_t seq_len = index->numel();
     size_t vocab_size = weight->shape()[0];
-    size_t hidden_dim = weight->shape()[1];
+    bool q4 = weight->dtype() == LLAISYS_DTYPE_U8;
+    size_t hidden_dim = q4 ? weight->shape()[1] * 2 : weight->shape()[1];
+
+    // 量化词表 (I8 每行 / q4 分组)
+    size_t group = 0;
+    if (weight->dtype() == LLAISYS_DTYPE_I8) {
+        ASSERT(weight_scale != nullptr && weight_scale->dtype() == LLAISYS_DTYPE_F32 && weight_scale->numel() == vocab_size,
+               "Embedding: I8 weight requires a [vocab] F32 weight_scale");
+        ASSERT(weight_zero == nullptr, "Embedding: I8 weights have no zero points");
+    } else if (q4) {
+        group = q4_group_size(weight, weight_scale, weight_zero, hidden_dim);
+    } else {
+        ASSERT(weight_scale == nullptr && weight_zero == nullptr,
+               "Embedding: weight_scale/weight_zero are only valid for quantized weights");
+    }
 
     llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
 
     if (out->deviceType() == LLAISYS_DEVICE_CPU) {
+        if (weight_scale) {
+            switch (out->dtype()) {
+            case LLAISYS_DTYPE_F32:
+                return cpu::embedding_quantized<float>(out->data(), index->data(), weight->data(), weight_scale->data(),
+                                                       weight_zero ? weight_zero->data() : nullptr, weight->dtype(),
+                                                       group, seq_len, hidden_dim, vocab_size);
+            case LLAISYS_DTYPE_F16:
+                return cpu::embedding_quantized<fp16_t>(out->data(), index->data(), weight->data(), weight_scale->data(),
+                                                        weight_zero ? weight_zero->data() : nullptr, weight->dtype(),
+                                                        group, seq_len, hidden_dim, vocab_size);
+            case LLAISYS_DTYPE_BF16:
+                return cpu::embedding_quantized<bf16_t>(out->data(), index->data(), weight->data(), weight_scale->data(),
+                                                        weight_zero ? weight_zero->data() : nullptr, weight->dtype(),
+                                                        group, seq_len, hidden_dim, vocab_size);
+            default:
+                EXCEPTION_UNSUPPORTED_DATATYPE(out->dtype());
+            }
+        }
+        // 输出 dtype 可以与词表不同，例如 BF16 词表查出 F32 激活
         switch (out->dtype()) {
         case LLAISYS_DTYPE_F32:
-            return cpu::embedding<float>(out->data(), index->data(), weight->data(), seq_len, hidden_dim, vocab_size);
+            return embedding_cpu<float>(out, index, weight, seq_len, hidden_dim, vocab_size);
         case LLAISYS_DTYPE_F16:
-            return cpu::embedding<fp16_t>(out->data(), index->data(), weight->data(), seq_len, hidden_dim, vocab_size);
+            return embedding_cpu<fp16_t>(out, index, weight, seq_len, hidden_dim, vocab_size);
         case LLAISYS_DTYPE_BF16:
-            return cpu::embedding<bf16_t>(out->data(), index->data(), weight->data(), seq_len, hidden_dim, vocab_size);
+            return embedding_cpu<bf16_t>(out, index, weight, seq_len, hidden_dim, vocab_size);
         default:
             EXCEPTION_UNSUPPORTED_DATATYPE(out->dtype());
         }
@@ -29,4 +79,4 @@ void embedding(tensor_t out, tensor_t index, tensor_t weight) {
          EXCEPTION_UNSUPPORTED_DEVICE;
     }
 }
-} // namespace llaisys::ops
\ No newline at end of file
+} // namespace llaisys::ops
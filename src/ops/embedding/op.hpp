@@ -3,5 +3,7 @@
 #include "../../tensor/tensor.hpp"
 
 namespace llaisys::ops {
-void embedding(tensor_t out, tensor_t index, tensor_t weight);
+// 量化词表的 weight_scale/weight_zero 与 ops::linear 相同
+void embedding(tensor_t out, tensor_t index, tensor_t weight, tensor_t weight_scale = nullptr,
+               tensor_t weight_zero = nullptr);
 }
@@ -0,0 +1,128 @@
+#include "kv_append_cpu.hpp"
+
+#include "../../../core/thread_pool/thread_pool.hpp"
+#include "../../../utils.hpp"
+#include "../../rope/cpu/rope_rotate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+namespace {
+// Converts one row of n values into the cache; I8 rows also write their scale.
+template <typename C, typename T>
+void store_row(C *dst, float *scale, const T *src, size_t n) {
+    if constexpr (std::is_same_v<C, int8_t>) {
+        float amax = 0.0f;
+        for (size_t d = 0; d < n; d++) {
+            amax = std::max(amax, std::fabs(llaisys::utils::cast<float>(src[d])));
+        }
+        // An all-zero row keeps scale 0 and quantizes to zeros.
+        const float inv = amax > 0.0f ? 127.0f / amax : 0.0f;
+        for (size_t d = 0; d < n; d++) {
+            const float q = std::nearbyint(llaisys::utils::cast<float>(src[d]) * inv);
+            dst[d] = static_cast<int8_t>(std::clamp(q, -127.0f, 127.0f));
+        }
+        *scale = amax / 127.0f;
+    } else if constexpr (std::is_same_v<C, T>) {
+        std::copy(src, src + n, dst);
+    } else {
+        for (size_t d = 0; d < n; d++) {
+            dst[d] = llaisys::utils::cast<C>(llaisys::utils::cast<float>(src[d]));
+        }
+    }
+}
+
+template <typename C, typename T>
+void kv_append_(C *k_cache, C *v_cache, float *k_scale, float *v_scale, const T *k, const T *v,
+                const int32_t *block_table, size_t block_size, size_t pos, size_t n, size_t n_kv_head,
+                size_t head_dim, size_t v_head_dim, size_t k_stride, size_t v_stride,
+                const llaisys::ops::cpu::KVAppendRope &rope) {
+    const T *q = reinterpret_cast<const T *>(rope.q);
+    T *q_out = reinterpret_cast<T *>(rope.q_out);
+    const size_t n_q_head = rope.table ? rope.n_heads : 0;
+    const size_t half_dim = head_dim / 2;
+    // The heads of token i are its q heads (only with RoPE) followed by its kv heads.
+    const size_t n_head = n_q_head + n_kv_head;
+    llaisys::core::parallel_for(n * n_head, 16, [&](size_t begin, size_t end) {
+        thread_local std::vector<T> rotated;
+        for (size_t task = begin; task < end; task++) {
+            const size_t i = task / n_head;
+            const size_t t = pos + i;
+            const float *cos = rope.table ? rope.table + t * head_dim : nullptr;
+            size_t h = task % n_head;
+            if (h < n_q_head) {
+                llaisys::ops::cpu::rope_rotate(q_out + i * rope.q_out_stride + h * head_dim,
+                                               q + i * rope.q_stride + h * head_dim, cos, cos + half_dim, half_dim);
+                continue;
+            }
+            h -= n_q_head;
+            // Index of the (token, kv head) slot in the cache, counted in rows of one head.
+            const size_t slot = (static_cast<size_t>(block_table[t / block_size]) * block_size + t % block_size) *
+                                    n_kv_head + h;
+            const T *k_row = k + i * k_stride + h * head_dim;
+            if (cos) {
+                // Rotated in the k/v type first, so the cache holds exactly what rope + kv_append would store.
+                rotated.resize(head_dim);
+                llaisys::ops::cpu::rope_rotate(rotated.data(), k_row, cos, cos + half_dim, half_dim);
+                k_row = rotated.data();
+            }
+            store_row(k_cache + slot * head_dim, k_scale ? k_scale + slot : nullptr, k_row, head_dim);
+            store_row(v_cache + slot * v_head_dim, v_scale ? v_scale + slot : nullptr,
+                      v + i * v_stride + h * v_head_dim, v_head_dim);
+        }
+    });
+}
+
+template <typename T>
+void kv_append_to(std::byte *k_cache, std::byte *v_cache, float *k_scale, float *v_scale, const T *k, const T *v,
+                  llaisysDataType_t cache_type, const int32_t *block_table, size_t block_size, size_t pos, size_t n,
+                  size_t n_kv_head, size_t head_dim, size_t v_head_dim, size_t k_stride, size_t v_stride,
+                  const llaisys::ops::cpu::KVAppendRope &rope) {
+    switch (cache_type) {
+    case LLAISYS_DTYPE_F32:
+        return kv_append_(reinterpret_cast<float *>(k_cache), reinterpret_cast<float *>(v_cache), k_scale, v_scale, k,
+                          v, block_table, block_size, pos, n, n_kv_head, head_dim, v_head_dim, k_stride, v_stride,
+                          rope);
+    case LLAISYS_DTYPE_BF16:
+        return kv_append_(reinterpret_cast<llaisys::bf16_t *>(k_cache), reinterpret_cast<llaisys::bf16_t *>(v_cache),
+                          k_scale, v_scale, k, v, block_table, block_size, pos, n, n_kv_head, head_dim, v_head_dim,
+                          k_stride, v_stride, rope);
+    case LLAISYS_DTYPE_F16:
+        return kv_append_(reinterpret_cast<llaisys::fp16_t *>(k_cache), reinterpret_cast<llaisys::fp16_t *>(v_cache),
+                          k_scale, v_scale, k, v, block_table, block_size, pos, n, n_kv_head, head_dim, v_head_dim,
+                          k_stride, v_stride, rope);
+    case LLAISYS_DTYPE_I8:
+        return kv_append_(reinterpret_cast<int8_t *>(k_cache), reinterpret_cast<int8_t *>(v_cache), k_scale, v_scale,
+                          k, v, block_table, block_size, pos, n, n_kv_head, head_dim, v_head_dim, k_stride,
+                          v_stride, rope);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(cache_type);
+    }
+}
+} // namespace
+
+namespace llaisys::ops::cpu {
+void kv_append(std::byte *k_cache, std::byte *v_cache, float *k_scale, float *v_scale, const std::byte *k,
+               const std::byte *v, llaisysDataType_t type, llaisysDataType_t cache_type,
+               const int32_t *block_table, size_t block_size, size_t pos, size_t n, size_t n_kv_head,
+               size_t head_dim, size_t v_head_dim, size_t k_stride, size_t v_stride, const KVAppendRope &rope) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return kv_append_to(k_cache, v_cache, k_scale, v_scale, reinterpret_cast<const float *>(k),
+                            reinterpret_cast<const float *>(v), cache_type, block_table, block_size, pos, n,
+                            n_kv_head, head_dim, v_head_dim, k_stride, v_stride, rope);
+    case LLAISYS_DTYPE_BF16:
+        return kv_append_to(k_cache, v_cache, k_scale, v_scale, reinterpret_cast<const bf16_t *>(k),
+                            reinterpret_cast<const bf16_t *>(v), cache_type, block_table, block_size, pos, n,
+                            n_kv_head, head_dim, v_head_dim, k_stride, v_stride, rope);
+    case LLAISYS_DTYPE_F16:
+        return kv_append_to(k_cache, v_cache, k_scale, v_scale, reinterpret_cast<const fp16_t *>(k),
+                            reinterpret_cast<const fp16_t *>(v), cache_type, block_table, block_size, pos, n,
+                            n_kv_head, head_dim, v_head_dim, k_stride, v_stride, rope);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+} // namespace llaisys::ops::cpu
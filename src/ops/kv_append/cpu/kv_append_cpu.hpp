@@ -0,0 +1,30 @@
+#pragma once
+#include "llaisys.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace llaisys::ops::cpu {
+// RoPE fused into the append (rope_kv_append). With a table (see rope_table), token i is at
+// position pos + i: its k heads are rotated before they are stored, and q: [n, n_heads, head_dim]
+// of the k/v type, token i at row i * q_stride, is rotated into q_out (row i * q_out_stride)
+// in the same pass. q_out may alias q.
+struct KVAppendRope {
+    const float *table = nullptr;
+    std::byte *q_out = nullptr;
+    const std::byte *q = nullptr;
+    size_t n_heads = 0;
+    size_t q_out_stride = 0;
+    size_t q_stride = 0;
+};
+
+// k: [n, n_kv_head, head_dim] and v: [n, n_kv_head, v_head_dim] of `type`, token i at row
+// i * k_stride / i * v_stride. Token i is stored as row (pos + i) % block_size of block
+// block_table[(pos + i) / block_size] of the paged caches, converted to `cache_type`.
+// I8 rows are quantized symmetrically per (token, kv head): scale = max|x| / 127, stored in
+// k_scale / v_scale laid out like the cache rows, [num_blocks, block_size, n_kv_head].
+void kv_append(std::byte *k_cache, std::byte *v_cache, float *k_scale, float *v_scale, const std::byte *k,
+               const std::byte *v, llaisysDataType_t type, llaisysDataType_t cache_type,
+               const int32_t *block_table, size_t block_size, size_t pos, size_t n, size_t n_kv_head,
+               size_t head_dim, size_t v_head_dim, size_t k_stride, size_t v_stride, const KVAppendRope &rope = {});
+}
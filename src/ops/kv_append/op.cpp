@@ -0,0 +1,116 @@
+#include "op.hpp"
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+#include "cpu/kv_append_cpu.hpp"
+
+namespace llaisys::ops {
+namespace {
+// kv_append 与 rope_kv_append 共用的校验与分发; rope.table 为空时不做旋转
+void append(tensor_t k_cache, tensor_t v_cache, tensor_t k_scale, tensor_t v_scale, tensor_t k, tensor_t v,
+            tensor_t block_table, size_t pos, const cpu::KVAppendRope &rope) {
+    CHECK_SAME_DEVICE(k_cache, v_cache, k);
+    CHECK_SAME_DEVICE(v, block_table, k);
+    CHECK_SAME_DTYPE(k->dtype(), v->dtype());
+    CHECK_SAME_DTYPE(k_cache->dtype(), v_cache->dtype());
+    ASSERT(block_table->dtype() == LLAISYS_DTYPE_I32, "KVAppend: block_table must be I32");
+    ASSERT(k->ndim() == 3 && v->ndim() == 3 && k_cache->ndim() == 4 && v_cache->ndim() == 4,
+           "KVAppend: k/v must be 3D and the caches 4D");
+
+    size_t n = k->shape()[0];
+    size_t n_kv_head = k->shape()[1];
+    size_t head_dim = k->shape()[2];
+    size_t v_head_dim = v->shape()[2];
+    size_t num_blocks = k_cache->shape()[0];
+    size_t block_size = k_cache->shape()[1];
+
+    ASSERT(v->shape()[0] == n && v->shape()[1] == n_kv_head, "KVAppend: k and v must hold the same tokens and heads");
+    ASSERT(k_cache->shape()[2] == n_kv_head && k_cache->shape()[3] == head_dim,
+           "KVAppend: k_cache must be [num_blocks, block_size, nkvhead, d]");
+    ASSERT(v_cache->shape()[0] == num_blocks && v_cache->shape()[1] == block_size &&
+               v_cache->shape()[2] == n_kv_head && v_cache->shape()[3] == v_head_dim,
+           "KVAppend: v_cache must be [num_blocks, block_size, nkvhead, dv]");
+    ASSERT(k_cache->isContiguous() && v_cache->isContiguous() && block_table->isContiguous(),
+           "KVAppend: caches and block_table must be contiguous");
+
+    // 每个 token 内 [nkvhead, d] 必须连续，token 之间可以有间隔
+    auto token_stride = [&](const tensor_t &t, size_t dim) {
+        ASSERT(t->strides()[2] == 1 && t->strides()[1] == (ptrdiff_t)dim, "KVAppend: heads of a token must be contiguous");
+        return (size_t)t->strides()[0];
+    };
+    size_t k_stride = token_stride(k, head_dim);
+    size_t v_stride = token_stride(v, v_head_dim);
+
+    bool quantized = k_cache->dtype() == LLAISYS_DTYPE_I8;
+    if (quantized) {
+        ASSERT(k_scale && v_scale, "KVAppend: an INT8 cache needs k_scale and v_scale");
+        CHECK_SAME_DEVICE(k_scale, v_scale, k);
+        CHECK_SAME_DTYPE(k_scale->dtype(), v_scale->dtype(), LLAISYS_DTYPE_F32);
+        CHECK_SAME_SHAPE(k_scale->shape(), v_scale->shape());
+        ASSERT(k_scale->ndim() == 3 && k_scale->shape()[0] == num_blocks && k_scale->shape()[1] == block_size &&
+                   k_scale->shape()[2] == n_kv_head,
+               "KVAppend: scales must be [num_blocks, block_size, nkvhead]");
+        ASSERT(k_scale->isContiguous() && v_scale->isContiguous(), "KVAppend: scales must be contiguous");
+    } else {
+        ASSERT(!k_scale && !v_scale, "KVAppend: only an INT8 cache takes scales");
+    }
+
+    size_t used_blocks = (pos + n + block_size - 1) / block_size;
+    ASSERT(block_table->numel() >= used_blocks, "KVAppend: block_table does not cover pos + n");
+
+    llaisys::core::context().setDevice(k_cache->deviceType(), k_cache->deviceId());
+
+    if (k_cache->deviceType() == LLAISYS_DEVICE_CPU) {
+        const auto *table = reinterpret_cast<const int32_t *>(block_table->data());
+        for (size_t b = pos / block_size; b < used_blocks; ++b) {
+            ASSERT(table[b] >= 0 && (size_t)table[b] < num_blocks, "KVAppend: block id out of range");
+        }
+        return cpu::kv_append(k_cache->data(), v_cache->data(),
+                              quantized ? reinterpret_cast<float *>(k_scale->data()) : nullptr,
+                              quantized ? reinterpret_cast<float *>(v_scale->data()) : nullptr, k->data(), v->data(),
+                              k->dtype(), k_cache->dtype(), table, block_size, pos, n, n_kv_head, head_dim,
+                              v_head_dim, k_stride, v_stride, rope);
+    } else {
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+} // namespace
+
+void kv_append(tensor_t k_cache, tensor_t v_cache, tensor_t k_scale, tensor_t v_scale, tensor_t k, tensor_t v,
+               tensor_t block_table, size_t pos) {
+    append(k_cache, v_cache, k_scale, v_scale, k, v, block_table, pos, {});
+}
+
+void rope_kv_append(tensor_t q_out, tensor_t k_cache, tensor_t v_cache, tensor_t k_scale, tensor_t v_scale, tensor_t q,
+                    tensor_t k, tensor_t v, tensor_t table, tensor_t block_table, size_t pos) {
+    CHECK_SAME_DEVICE(q_out, q, k);
+    CHECK_SAME_DEVICE(table, k);
+    CHECK_SAME_DTYPE(q_out->dtype(), q->dtype(), k->dtype());
+    CHECK_SAME_SHAPE(q_out->shape(), q->shape());
+    ASSERT(q->ndim() == 3 && k->ndim() == 3, "RoPEKVAppend: q and k must be 3D");
+
+    size_t n = k->shape()[0];
+    size_t head_dim = k->shape()[2];
+    ASSERT(q->shape()[0] == n && q->shape()[2] == head_dim, "RoPEKVAppend: q must be [n, nhead, d] like k");
+    ASSERT(head_dim % 2 == 0, "RoPEKVAppend: head_dim must be even");
+    ASSERT(table->dtype() == LLAISYS_DTYPE_F32 && table->isContiguous(), "RoPEKVAppend: table must be contiguous F32");
+    ASSERT(table->ndim() == 3 && table->shape()[1] == 2 && table->shape()[2] == head_dim / 2,
+           "RoPEKVAppend: table must be [max_pos, 2, head_dim / 2]");
+    ASSERT(pos + n <= table->shape()[0], "RoPEKVAppend: position outside the table");
+
+    // 与 k 相同，每个 token 内 [nhead, d] 必须连续，token 之间可以有间隔
+    auto token_stride = [&](const tensor_t &t) {
+        ASSERT(t->strides()[2] == 1 && t->strides()[1] == (ptrdiff_t)head_dim,
+               "RoPEKVAppend: heads of a token must be contiguous");
+        return (size_t)t->strides()[0];
+    };
+
+    cpu::KVAppendRope rope;
+    rope.table = reinterpret_cast<const float *>(table->data());
+    rope.q_out = q_out->data();
+    rope.q = q->data();
+    rope.n_heads = q->shape()[1];
+    rope.q_out_stride = token_stride(q_out);
+    rope.q_stride = token_stride(q);
+    append(k_cache, v_cache, k_scale, v_scale, k, v, block_table, pos, rope);
+}
+} // namespace llaisys::ops
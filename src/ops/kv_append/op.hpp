@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../../tensor/tensor.hpp"
+
+namespace llaisys::ops {
+// 把位置 pos 起 n 个 token 的 k: [n, nkvhead, d] 与 v: [n, nkvhead, dv] 写入分页 cache
+// (布局见 paged_attention)，第 pos + i 个 token 落在 block_table[(pos + i) / block_size] 块。
+// 写入时转换为 cache 的类型: F32/BF16/F16 直接转换; INT8 按 (token, kv head) 对称量化，
+// scale = max|x| / 127 写入 F32 的 k_scale / v_scale [num_blocks, block_size, nkvhead]，非 INT8 时传 nullptr。
+// k/v 每个 token 内的 [nkvhead, d] 必须连续，token 之间可以有间隔 (可直接读取融合 QKV 输出)
+void kv_append(tensor_t k_cache, tensor_t v_cache, tensor_t k_scale, tensor_t v_scale, tensor_t k, tensor_t v,
+               tensor_t block_table, size_t pos);
+
+// 融合 RoPE 的 kv_append: 一遍完成 q 的旋转 (q -> q_out，可以是同一张量)、k 的旋转与 k/v 写入 cache。
+// q: [n, nhead, d] 与 k/v 同类型，token 内连续的要求同 k; 第 i 个 token 位于 pos + i，
+// cos/sin 取自 table (见 rope_table) 的第 pos + i 行。cache 中的结果与先 rope 再 kv_append 逐位相同
+void rope_kv_append(tensor_t q_out, tensor_t k_cache, tensor_t v_cache, tensor_t k_scale, tensor_t v_scale, tensor_t q,
+                    tensor_t k, tensor_t v, tensor_t table, tensor_t block_table, size_t pos);
+}
@@ -0,0 +1,738 @@
+#include "linear_cpu.hpp"
+
+#include "../../../core/thread_pool/thread_pool.hpp"
+#include "../../../utils.hpp"
+#include "../../../utils/simd_math.hpp"
+#include "../../quantize/cpu/quantize_cpu.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+namespace simd = llaisys::utils::simd;
+
+// Register tile of the micro-kernel: MR rows of X times NR columns of W^T,
+// kept in 2 * MR vector accumulators.
+#if defined(LLAISYS_SIMD_AVX512)
+constexpr size_t MR = 8;
+#else
+constexpr size_t MR = 6;
+#endif
+constexpr size_t NR = 2 * simd::width;
+
+// Cache blocking: a KC x NR sliver of W stays in L1, the packed MC x KC block of X
+// in L2, and the packed KC x NC slab of W in L2/L3.
+constexpr size_t KC = 256;
+constexpr size_t MC = MR * 16;
+constexpr size_t NC = NR * 32;
+
+// Group-quantized 4-bit weight, see quantize_cpu.hpp for the layout.
+struct Q4Weight {
+    const uint8_t *q;              // [N, K / 2]
+    const llaisys::fp16_t *scale;  // [N, K / group]
+    const uint8_t *zero;           // [N, K / group], null for symmetric groups
+    size_t group;
+};
+
+// Weight prepacked once by linear_pack_weight: every NR rows of W form one [K][NR] panel,
+// the same layout pack_b produces per KC block, so tiles read it in place.
+template <typename W>
+struct PanelWeight {
+    const W *p;
+};
+template <typename W>
+constexpr bool is_panel_weight = false;
+template <typename W>
+constexpr bool is_panel_weight<PanelWeight<W>> = true;
+
+// Element type of the packed W panels: weights keep their storage type, except q4
+// which is dequantized to F32 while packing.
+template <typename W>
+struct Packed {
+    using type = W;
+};
+template <>
+struct Packed<Q4Weight> {
+    using type = float;
+};
+template <typename W>
+struct Packed<PanelWeight<W>> {
+    using type = W;
+};
+
+// Ap[panel][k][i] = X[m0 + panel * MR + i][k0 + k], rows past mc are zero.
+template <typename T>
+void pack_a(float *ap, const T *x, size_t K, size_t m0, size_t mc, size_t k0, size_t kc) {
+    for (size_t p = 0; p < mc; p += MR) {
+        size_t rows = std::min(MR, mc - p);
+        for (size_t i = 0; i < MR; i++) {
+            if (i < rows) {
+                const T *src = x + (m0 + p + i) * K + k0;
+                for (size_t k = 0; k < kc; k++) {
+                    ap[k * MR + i] = llaisys::utils::cast<float>(src[k]);
+                }
+            } else {
+                for (size_t k = 0; k < kc; k++) {
+                    ap[k * MR + i] = 0.0f;
+                }
+            }
+        }
+        ap += kc * MR;
+    }
+}
+
+// Bp[panel][k][j] = W[n0 + panel * NR + j][k0 + k], columns past nc are zero.
+// W keeps its own element type; conversion to F32 happens in registers.
+template <typename W>
+void pack_b(W *bp, const W *w, size_t K, size_t n0, size_t nc, size_t k0, size_t kc) {
+    for (size_t p = 0; p < nc; p += NR) {
+        size_t cols = std::min(NR, nc - p);
+        for (size_t j = 0; j < NR; j++) {
+            if (j < cols) {
+                const W *src = w + (n0 + p + j) * K + k0;
+                for (size_t k = 0; k < kc; k++) {
+                    bp[k * NR + j] = src[k];
+                }
+            } else {
+                for (size_t k = 0; k < kc; k++) {
+                    bp[k * NR + j] = W{};
+                }
+            }
+        }
+        bp += kc * NR;
+    }
+}
+
+// k0 and kc are multiples of the q4 block (KC is, and K is a multiple of the group),
+// so every row is dequantized one whole block at a time.
+void pack_b(float *bp, const Q4Weight *w, size_t K, size_t n0, size_t nc, size_t k0, size_t kc) {
+    using llaisys::ops::cpu::Q4_BLOCK;
+    size_t groups = K / w->group;
+    for (size_t p = 0; p < nc; p += NR) {
+        size_t cols = std::min(NR, nc - p);
+        for (size_t j = 0; j < NR; j++) {
+            if (j >= cols) {
+                for (size_t k = 0; k < kc; k++) {
+                    bp[k * NR + j] = 0.0f;
+                }
+                continue;
+            }
+            size_t n = n0 + p + j;
+            const uint8_t *row = w->q + n * (K / 2);
+            for (size_t kb = 0; kb < kc; kb += Q4_BLOCK) {
+                size_t g = n * groups + (k0 + kb) / w->group;
+                float s = llaisys::utils::cast<float>(w->scale[g]);
+                float z = w->zero ? w->zero[g] : llaisys::ops::cpu::Q4_SYMMETRIC_ZERO;
+                const uint8_t *block = row + (k0 + kb) / 2;
+                float *dst = bp + kb * NR + j;
+                for (size_t i = 0; i < Q4_BLOCK / 2; i++) {
+                    dst[i * NR] = ((block[i] & 0x0F) - z) * s;
+                    dst[(i + Q4_BLOCK / 2) * NR] = ((block[i] >> 4) - z) * s;
+                }
+            }
+        }
+        bp += kc * NR;
+    }
+}
+
+// C[MR, NR] (+)= Ap[MR, kc] * Bp[kc, NR]
+template <typename W>
+void micro_kernel(size_t kc, const float *a, const W *b, float *c, size_t ldc, bool accumulate) {
+    simd::vfloat acc0[MR], acc1[MR];
+    for (size_t i = 0; i < MR; i++) {
+        acc0[i] = simd::zero();
+        acc1[i] = simd::zero();
+    }
+    for (size_t k = 0; k < kc; k++) {
+        simd::vfloat b0 = simd::load(b + k * NR);
+        simd::vfloat b1 = simd::load(b + k * NR + simd::width);
+        for (size_t i = 0; i < MR; i++) {
+            simd::vfloat ai = simd::set1(a[k * MR + i]);
+            acc0[i] = simd::fmadd(ai, b0, acc0[i]);
+            acc1[i] = simd::fmadd(ai, b1, acc1[i]);
+        }
+    }
+    for (size_t i = 0; i < MR; i++) {
+        float *row = c + i * ldc;
+        if (accumulate) {
+            acc0[i] = simd::add(acc0[i], simd::load(row));
+            acc1[i] = simd::add(acc1[i], simd::load(row + simd::width));
+        }
+        simd::store(row, acc0[i]);
+        simd::store(row + simd::width, acc1[i]);
+    }
+}
+
+// Work done on finished F32 accumulators while they are stored, see LinearEpilogue.
+struct Epilogue {
+    const float *scale;    // per-row dequantization scale [N] or null
+    const float *bias;     // [N] or null
+    const void *residual;  // output-shaped, of the output type, or null
+    float alpha;
+    bool swiglu;           // columns are (gate, up) pairs, each pair stores one silu(gate) * up
+};
+
+inline float epilogue_value(float v, size_t n, const Epilogue &ep) {
+    if (ep.scale) {
+        v *= ep.scale[n];
+    }
+    if (ep.alpha != 1.0f) {
+        v *= ep.alpha;
+    }
+    if (ep.bias) {
+        v += ep.bias[n];
+    }
+    return v;
+}
+
+// out[m0 + m, :] <- epilogue(c[m, 0:cols]) for columns n0..n0+cols of the GEMM result.
+// With swiglu, n0 and cols are even and the outputs land at column n0 / 2 of an N / 2 wide row.
+// Each output is read from `residual` before it is written, so the two may alias.
+template <typename T>
+void store_rows(T *out, size_t ldo, size_t m0, const float *c, size_t ldc, size_t rows, size_t n0, size_t cols,
+                const Epilogue &ep) {
+    for (size_t m = 0; m < rows; m++) {
+        const float *src = c + m * ldc;
+        T *dst = out + (m0 + m) * ldo;
+        const T *res = ep.residual ? reinterpret_cast<const T *>(ep.residual) + (m0 + m) * ldo : nullptr;
+        if (!ep.swiglu) {
+            for (size_t j = 0; j < cols; j++) {
+                float v = epilogue_value(src[j], n0 + j, ep);
+                if (res) {
+                    v += llaisys::utils::cast<float>(res[n0 + j]);
+                }
+                dst[n0 + j] = llaisys::utils::cast<T>(v);
+            }
+            continue;
+        }
+        // silu runs on simd::width pairs at a time, the last chunk zero-padded: every lane computes
+        // exactly what ops::swiglu does, so the fused path matches the unfused one.
+        for (size_t j = 0; j < cols; j += 2 * simd::width) {
+            size_t pairs = std::min(simd::width, (cols - j) / 2);
+            float g[simd::width] = {}, u[simd::width] = {}, v[simd::width];
+            for (size_t k = 0; k < pairs; k++) {
+                g[k] = epilogue_value(src[j + 2 * k], n0 + j + 2 * k, ep);
+                u[k] = epilogue_value(src[j + 2 * k + 1], n0 + j + 2 * k + 1, ep);
+            }
+            simd::store(v, simd::mul(simd::load(u), simd::silu(simd::load(g))));
+            for (size_t k = 0; k < pairs; k++) {
+                size_t o = (n0 + j) / 2 + k;
+                float value = v[k];
+                if (res) {
+                    value += llaisys::utils::cast<float>(res[o]);
+                }
+                dst[o] = llaisys::utils::cast<T>(value);
+            }
+        }
+    }
+}
+
+// Edge tiles go through a full-size scratch tile so the micro-kernel never sees partial shapes.
+template <typename W>
+void edge_kernel(size_t kc, const float *a, const W *b, float *c, size_t ldc, size_t rows, size_t cols, bool accumulate) {
+    float tile[MR * NR];
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j++) {
+            tile[i * NR + j] = accumulate ? c[i * ldc + j] : 0.0f;
+        }
+    }
+    micro_kernel(kc, a, b, tile, NR, true);
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j++) {
+            c[i * ldc + j] = tile[i * NR + j];
+        }
+    }
+}
+
+// Decode-sized inputs are bandwidth bound: skip packing and stream each weight row
+// exactly once, dotting it against all M input rows while it is in registers.
+constexpr size_t GEMV_MAX_M = 4;
+// Distance in bytes at which weight rows are prefetched ahead of the loads.
+constexpr size_t GEMV_PREFETCH = 512;
+// Weight rows per parallel task, a multiple of every row block below.
+constexpr size_t GEMV_GRAIN = 16;
+
+// y[0:M, 0:n1-n0] = X * W[n0:n1]^T, with R weight rows in flight per step.
+template <size_t M, size_t R, typename W>
+void gemv_rows(float *y, size_t ldy, const float *x, const W *weight, size_t K, size_t n0, size_t n1) {
+    constexpr size_t prefetch_ahead = GEMV_PREFETCH / sizeof(W);
+    size_t k_vec = K - K % simd::width;
+    size_t n = n0;
+    for (; n + R <= n1; n += R) {
+        const W *w[R];
+        simd::vfloat acc[R][M];
+        for (size_t r = 0; r < R; r++) {
+            w[r] = weight + (n + r) * K;
+            for (size_t m = 0; m < M; m++) {
+                acc[r][m] = simd::zero();
+            }
+        }
+        for (size_t k = 0; k < k_vec; k += simd::width) {
+            simd::vfloat xv[M];
+            for (size_t m = 0; m < M; m++) {
+                xv[m] = simd::load(x + m * K + k);
+            }
+            for (size_t r = 0; r < R; r++) {
+                simd::prefetch(w[r] + k + prefetch_ahead);
+                simd::vfloat wv = simd::load(w[r] + k);
+                for (size_t m = 0; m < M; m++) {
+                    acc[r][m] = simd::fmadd(wv, xv[m], acc[r][m]);
+                }
+            }
+        }
+        for (size_t r = 0; r < R; r++) {
+            for (size_t m = 0; m < M; m++) {
+                float sum = simd::reduce_add(acc[r][m]);
+                for (size_t k = k_vec; k < K; k++) {
+                    sum += llaisys::utils::cast<float>(w[r][k]) * x[m * K + k];
+                }
+                y[m * ldy + n + r - n0] = sum;
+            }
+        }
+    }
+    if (n < n1) {
+        gemv_rows<M, 1>(y + n - n0, ldy, x, weight, K, n, n1);
+    }
+}
+
+template <size_t R, typename W>
+void gemv_block(size_t M, float *y, const float *x, const W *weight, size_t K, size_t n0, size_t n1) {
+    switch (M) {
+    case 1:
+        return gemv_rows<1, R>(y, GEMV_GRAIN, x, weight, K, n0, n1);
+    case 2:
+        return gemv_rows<2, R>(y, GEMV_GRAIN, x, weight, K, n0, n1);
+    case 3:
+        return gemv_rows<3, R / 2>(y, GEMV_GRAIN, x, weight, K, n0, n1);
+    default:
+        return gemv_rows<4, R / 2>(y, GEMV_GRAIN, x, weight, K, n0, n1);
+    }
+}
+
+// Runs `block(y, n0, n1)` over GEMV_GRAIN-wide column blocks in parallel and stores each
+// block through the epilogue, so the raw dot products never leave the stack.
+template <typename T, typename Block>
+void gemv_store(T *out, size_t ldo, size_t M, size_t N, const Epilogue &ep, const Block &block) {
+    llaisys::core::parallel_for(N, GEMV_GRAIN, [&](size_t n0, size_t n1) {
+        float y[GEMV_MAX_M * GEMV_GRAIN];
+        for (size_t nb = n0; nb < n1; nb += GEMV_GRAIN) {
+            size_t ne = std::min(nb + GEMV_GRAIN, n1);
+            block(y, nb, ne);
+            store_rows(out, ldo, 0, y, GEMV_GRAIN, M, nb, ne - nb, ep);
+        }
+    });
+}
+
+// The GEMV kernels read the input rows in F32.
+template <typename T>
+const float *gemv_input(const T *in, size_t n) {
+    if constexpr (std::is_same_v<T, float>) {
+        return in;
+    } else {
+        thread_local std::vector<float> x_buf;
+        x_buf.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            x_buf[i] = llaisys::utils::cast<float>(in[i]);
+        }
+        return x_buf.data();
+    }
+}
+
+template <typename T, typename W>
+void gemv_(T *out, size_t ldo, const T *in, const W *weight, const Epilogue &ep, size_t M, size_t N, size_t K) {
+    const float *x = gemv_input(in, M * K);
+    gemv_store(out, ldo, M, N, ep, [&](float *y, size_t n0, size_t n1) {
+        gemv_block<4>(M, y, x, weight, K, n0, n1);
+    });
+}
+
+// y[0:M, 0:P * NR] = X * W[P panels]^T. Each step loads the NR weights of one k from every
+// panel and broadcasts x[m, k]; P panels stream side by side, like the R rows of gemv_rows,
+// which keeps enough loads and FMA chains in flight when M is small.
+template <size_t M, size_t P, typename W>
+void gemv_panels(float *y, size_t ldy, const float *x, const W *panels, size_t K) {
+    constexpr size_t prefetch_ahead = GEMV_PREFETCH / sizeof(W);
+    simd::vfloat acc[P][M][2];
+    for (size_t p = 0; p < P; p++) {
+        for (size_t m = 0; m < M; m++) {
+            acc[p][m][0] = simd::zero();
+            acc[p][m][1] = simd::zero();
+        }
+    }
+    for (size_t k = 0; k < K; k++) {
+        simd::vfloat xv[M];
+        for (size_t m = 0; m < M; m++) {
+            xv[m] = simd::set1(x[m * K + k]);
+        }
+        for (size_t p = 0; p < P; p++) {
+            const W *b = panels + p * K * NR + k * NR;
+            simd::prefetch(b + prefetch_ahead);
+            simd::vfloat b0 = simd::load(b);
+            simd::vfloat b1 = simd::load(b + simd::width);
+            for (size_t m = 0; m < M; m++) {
+                acc[p][m][0] = simd::fmadd(xv[m], b0, acc[p][m][0]);
+                acc[p][m][1] = simd::fmadd(xv[m], b1, acc[p][m][1]);
+            }
+        }
+    }
+    for (size_t p = 0; p < P; p++) {
+        for (size_t m = 0; m < M; m++) {
+            simd::store(y + m * ldy + p * NR, acc[p][m][0]);
+            simd::store(y + m * ldy + p * NR + simd::width, acc[p][m][1]);
+        }
+    }
+}
+
+// Panels per step for M input rows, and with it the parallel grain.
+constexpr size_t GEMV_PANELS = 4;
+
+template <size_t M, size_t P, typename W>
+void gemv_panel_block(float *y, const float *x, const W *panels, size_t K, size_t count) {
+    size_t p = 0;
+    for (; p + P <= count; p += P) {
+        gemv_panels<M, P>(y + p * NR, GEMV_PANELS * NR, x, panels + p * K * NR, K);
+    }
+    for (; p < count; p++) {
+        gemv_panels<M, 1>(y + p * NR, GEMV_PANELS * NR, x, panels + p * K * NR, K);
+    }
+}
+
+template <typename T, typename W>
+void gemv_(T *out, size_t ldo, const T *in, const PanelWeight<W> *weight, const Epilogue &ep, size_t M, size_t N,
+           size_t K) {
+    const float *x = gemv_input(in, M * K);
+    size_t panels = (N + NR - 1) / NR;
+    llaisys::core::parallel_for(panels, GEMV_PANELS, [&](size_t p0, size_t p1) {
+        float y[GEMV_MAX_M * GEMV_PANELS * NR];
+        for (size_t pb = p0; pb < p1; pb += GEMV_PANELS) {
+            size_t count = std::min(GEMV_PANELS, p1 - pb);
+            const W *block = weight->p + pb * K * NR;
+            switch (M) {
+            case 1:
+                gemv_panel_block<1, 4>(y, x, block, K, count);
+                break;
+            case 2:
+                gemv_panel_block<2, 2>(y, x, block, K, count);
+                break;
+            case 3:
+                gemv_panel_block<3, 1>(y, x, block, K, count);
+                break;
+            default:
+                gemv_panel_block<4, 1>(y, x, block, K, count);
+                break;
+            }
+            size_t n0 = pb * NR;
+            store_rows(out, ldo, 0, y, GEMV_PANELS * NR, M, n0, std::min(count * NR, N - n0), ep);
+        }
+    });
+}
+
+// Q4 GEMV: each group is dotted against the raw 4-bit values, then scaled once.
+// The zero point folds into a per-group correction z * s * sum(x[group]).
+template <size_t M, size_t R>
+void gemv_q4_rows(float *y, size_t ldy, const float *x, const float *xsum, const Q4Weight &w, size_t K,
+                  size_t n0, size_t n1) {
+    constexpr size_t V = simd::q4_block / simd::width;
+    size_t groups = K / w.group;
+    size_t n = n0;
+    for (; n + R <= n1; n += R) {
+        simd::vfloat acc[R][M];
+        float corr[R][M] = {};
+        for (size_t r = 0; r < R; r++) {
+            for (size_t m = 0; m < M; m++) {
+                acc[r][m] = simd::zero();
+            }
+        }
+        for (size_t g = 0; g < groups; g++) {
+            simd::vfloat part[R][M];
+            for (size_t r = 0; r < R; r++) {
+                for (size_t m = 0; m < M; m++) {
+                    part[r][m] = simd::zero();
+                }
+            }
+            for (size_t k = g * w.group; k < (g + 1) * w.group; k += simd::q4_block) {
+                simd::vfloat xv[M][V];
+                for (size_t m = 0; m < M; m++) {
+                    for (size_t v = 0; v < V; v++) {
+                        xv[m][v] = simd::load(x + m * K + k + v * simd::width);
+                    }
+                }
+                for (size_t r = 0; r < R; r++) {
+                    const uint8_t *qp = w.q + (n + r) * (K / 2) + k / 2;
+                    simd::prefetch(qp + GEMV_PREFETCH);
+                    simd::vfloat qv[V];
+                    simd::load_q4(qp, qv);
+                    for (size_t m = 0; m < M; m++) {
+                        for (size_t v = 0; v < V; v++) {
+                            part[r][m] = simd::fmadd(qv[v], xv[m][v], part[r][m]);
+                        }
+                    }
+                }
+            }
+            for (size_t r = 0; r < R; r++) {
+                size_t idx = (n + r) * groups + g;
+                float s = llaisys::utils::cast<float>(w.scale[idx]);
+                float z = w.zero ? w.zero[idx] : llaisys::ops::cpu::Q4_SYMMETRIC_ZERO;
+                simd::vfloat sv = simd::set1(s);
+                for (size_t m = 0; m < M; m++) {
+                    acc[r][m] = simd::fmadd(part[r][m], sv, acc[r][m]);
+                    corr[r][m] += s * z * xsum[m * groups + g];
+                }
+            }
+        }
+        for (size_t r = 0; r < R; r++) {
+            for (size_t m = 0; m < M; m++) {
+                y[m * ldy + n + r - n0] = simd::reduce_add(acc[r][m]) - corr[r][m];
+            }
+        }
+    }
+    if (n < n1) {
+        gemv_q4_rows<M, 1>(y + n - n0, ldy, x, xsum, w, K, n, n1);
+    }
+}
+
+template <typename T>
+void gemv_(T *out, size_t ldo, const T *in, const Q4Weight *weight, const Epilogue &ep, size_t M, size_t N, size_t K) {
+    thread_local std::vector<float> x_buf;
+    thread_local std::vector<float> xsum_buf;
+    size_t groups = K / weight->group;
+    x_buf.resize(M * K);
+    xsum_buf.assign(M * groups, 0.0f);
+    for (size_t i = 0; i < M * K; i++) {
+        x_buf[i] = llaisys::utils::cast<float>(in[i]);
+        xsum_buf[(i / K) * groups + (i % K) / weight->group] += x_buf[i];
+    }
+    const float *x = x_buf.data();
+    const float *xsum = xsum_buf.data();
+    const Q4Weight &w = *weight;
+    gemv_store(out, ldo, M, N, ep, [&](float *y, size_t n0, size_t n1) {
+        switch (M) {
+        case 1:
+            return gemv_q4_rows<1, 4>(y, GEMV_GRAIN, x, xsum, w, K, n0, n1);
+        case 2:
+            return gemv_q4_rows<2, 2>(y, GEMV_GRAIN, x, xsum, w, K, n0, n1);
+        case 3:
+            return gemv_q4_rows<3, 2>(y, GEMV_GRAIN, x, xsum, w, K, n0, n1);
+        default:
+            return gemv_q4_rows<4, 2>(y, GEMV_GRAIN, x, xsum, w, K, n0, n1);
+        }
+    });
+}
+
+// Y[m0:m0+mc, n0:n0+nc], independent of every other tile so tiles can run on any thread.
+template <typename T, typename W>
+void gemm_tile(T *out, size_t ldo, const T *in, const W *weight, const Epilogue &ep, size_t K,
+               size_t m0, size_t mc, size_t n0, size_t nc) {
+    thread_local std::vector<float> a_pack;
+    using P = typename Packed<W>::type;
+    thread_local std::vector<P> b_pack;
+    thread_local std::vector<float> c_buf;
+    a_pack.resize(MC * KC);
+    if constexpr (!is_panel_weight<W>) {
+        b_pack.resize(KC * NC);
+    }
+
+    // Accumulate in F32; for F32 outputs of the same width that is the output itself,
+    // unless it still holds the residual.
+    float *c = nullptr;
+    size_t ldc = nc;
+    if constexpr (std::is_same_v<T, float>) {
+        if (!ep.swiglu && !ep.residual) {
+            c = out + m0 * ldo + n0;
+            ldc = ldo;
+        }
+    }
+    if (c == nullptr) {
+        c_buf.resize(mc * nc);
+        c = c_buf.data();
+    }
+    if (K == 0) {
+        for (size_t m = 0; m < mc; m++) {
+            std::fill(c + m * ldc, c + m * ldc + nc, 0.0f);
+        }
+    }
+
+    for (size_t k0 = 0; k0 < K; k0 += KC) {
+        size_t kc = std::min(KC, K - k0);
+        bool accumulate = k0 > 0;
+        // Prepacked weights are used in place; everything else is packed per KC block.
+        const P *b_panels;
+        size_t panel_stride;
+        if constexpr (is_panel_weight<W>) {
+            b_panels = weight->p + (n0 / NR) * K * NR + k0 * NR;
+            panel_stride = K * NR;
+        } else {
+            pack_b(b_pack.data(), weight, K, n0, nc, k0, kc);
+            b_panels = b_pack.data();
+            panel_stride = kc * NR;
+        }
+        pack_a(a_pack.data(), in, K, m0, mc, k0, kc);
+
+        for (size_t jr = 0; jr < nc; jr += NR) {
+            const P *bp = b_panels + (jr / NR) * panel_stride;
+            size_t cols = std::min(NR, nc - jr);
+            for (size_t ir = 0; ir < mc; ir += MR) {
+                const float *ap = a_pack.data() + (ir / MR) * kc * MR;
+                float *ct = c + ir * ldc + jr;
+                size_t rows = std::min(MR, mc - ir);
+                if (rows == MR && cols == NR) {
+                    micro_kernel(kc, ap, bp, ct, ldc, accumulate);
+                } else {
+                    edge_kernel(kc, ap, bp, ct, ldc, rows, cols, accumulate);
+                }
+            }
+        }
+    }
+
+    store_rows(out, ldo, m0, c, ldc, mc, n0, nc, ep);
+}
+
+template <typename T, typename W>
+void linear_(T *out, const T *in, const W *weight, const Epilogue &ep, size_t M, size_t N, size_t K) {
+    size_t ldo = ep.swiglu ? N / 2 : N;
+    if (M <= GEMV_MAX_M) {
+        return gemv_(out, ldo, in, weight, ep, M, N, K);
+    }
+
+    // Narrow the N blocks until every thread has a few tiles to balance.
+    size_t m_tiles = (M + MC - 1) / MC;
+    size_t nc = NC;
+    while (nc > 4 * NR && m_tiles * ((N + nc - 1) / nc) < 4 * llaisys::core::threadPool().numThreads()) {
+        nc /= 2;
+    }
+    size_t n_tiles = (N + nc - 1) / nc;
+    llaisys::core::parallel_for(m_tiles * n_tiles, 1, [&](size_t t0, size_t t1) {
+        for (size_t t = t0; t < t1; t++) {
+            size_t m0 = (t / n_tiles) * MC;
+            size_t n0 = (t % n_tiles) * nc;
+            gemm_tile(out, ldo, in, weight, ep, K, m0, std::min(MC, M - m0), n0, std::min(nc, N - n0));
+        }
+    });
+}
+} // namespace
+
+namespace llaisys::ops::cpu {
+namespace {
+// Prepacked weights are wrapped so the kernels read them in place.
+template <typename T, typename W>
+void linear_typed_(std::byte *out, const std::byte *in, const std::byte *weight, bool weight_packed,
+                   const Epilogue &ep, size_t M, size_t N, size_t K) {
+    T *y = reinterpret_cast<T *>(out);
+    const T *x = reinterpret_cast<const T *>(in);
+    const W *w = reinterpret_cast<const W *>(weight);
+    if (weight_packed) {
+        PanelWeight<W> panels{w};
+        return linear_(y, x, &panels, ep, M, N, K);
+    }
+    return linear_(y, x, w, ep, M, N, K);
+}
+
+template <typename T>
+void linear_weight_(std::byte *out, const std::byte *in, const std::byte *weight, const std::byte *weight_scale,
+                    const std::byte *weight_zero, size_t group, llaisysDataType_t weight_type, bool weight_packed,
+                    size_t M, size_t N, size_t K, Epilogue ep) {
+    ep.scale = reinterpret_cast<const float *>(weight_scale);
+    switch (weight_type) {
+    case LLAISYS_DTYPE_F32:
+        return linear_typed_<T, float>(out, in, weight, weight_packed, ep, M, N, K);
+    case LLAISYS_DTYPE_BF16:
+        return linear_typed_<T, llaisys::bf16_t>(out, in, weight, weight_packed, ep, M, N, K);
+    case LLAISYS_DTYPE_F16:
+        return linear_typed_<T, llaisys::fp16_t>(out, in, weight, weight_packed, ep, M, N, K);
+    case LLAISYS_DTYPE_I8:
+        return linear_typed_<T, int8_t>(out, in, weight, weight_packed, ep, M, N, K);
+    case LLAISYS_DTYPE_U8: {
+        if (weight_packed) {
+            EXCEPTION_UNSUPPORTED_DATATYPE(weight_type);
+        }
+        Q4Weight q4{reinterpret_cast<const uint8_t *>(weight), reinterpret_cast<const llaisys::fp16_t *>(weight_scale),
+                    reinterpret_cast<const uint8_t *>(weight_zero), group};
+        // q4 scales are applied per group inside the kernels
+        ep.scale = nullptr;
+        return linear_(reinterpret_cast<T *>(out), reinterpret_cast<const T *>(in), &q4, ep, M, N, K);
+    }
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(weight_type);
+    }
+}
+
+template <typename W>
+void pack_weight_(std::byte *packed, const std::byte *weight, size_t N, size_t K) {
+    W *dst = reinterpret_cast<W *>(packed);
+    const W *w = reinterpret_cast<const W *>(weight);
+    size_t panels = (N + NR - 1) / NR;
+    llaisys::core::parallel_for(panels, 1, [&](size_t p0, size_t p1) {
+        for (size_t p = p0; p < p1; p++) {
+            pack_b(dst + p * K * NR, w, K, p * NR, std::min(NR, N - p * NR), 0, K);
+        }
+    });
+}
+
+template <typename B>
+const float *bias_to_f32(const std::byte *bias, size_t N) {
+    thread_local std::vector<float> buf;
+    buf.resize(N);
+    const B *src = reinterpret_cast<const B *>(bias);
+    for (size_t i = 0; i < N; i++) {
+        buf[i] = llaisys::utils::cast<float>(src[i]);
+    }
+    return buf.data();
+}
+} // namespace
+
+size_t linear_panel_rows() {
+    return NR;
+}
+
+void linear_pack_weight(std::byte *packed, const std::byte *weight, llaisysDataType_t weight_type, size_t N, size_t K) {
+    switch (weight_type) {
+    case LLAISYS_DTYPE_F32:
+        return pack_weight_<float>(packed, weight, N, K);
+    case LLAISYS_DTYPE_BF16:
+        return pack_weight_<llaisys::bf16_t>(packed, weight, N, K);
+    case LLAISYS_DTYPE_F16:
+        return pack_weight_<llaisys::fp16_t>(packed, weight, N, K);
+    case LLAISYS_DTYPE_I8:
+        return pack_weight_<int8_t>(packed, weight, N, K);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(weight_type);
+    }
+}
+
+void linear(std::byte *out, const std::byte *in, const std::byte *weight, const std::byte *weight_scale,
+            const std::byte *weight_zero, size_t group, llaisysDataType_t type, llaisysDataType_t weight_type,
+            bool weight_packed, size_t M, size_t N, size_t K, const LinearEpilogue &epilogue) {
+    Epilogue ep{nullptr, nullptr, epilogue.residual, epilogue.alpha, epilogue.swiglu};
+    // The kernels read the bias once per output column, in F32.
+    if (epilogue.bias) {
+        switch (epilogue.bias_type) {
+        case LLAISYS_DTYPE_F32:
+            ep.bias = reinterpret_cast<const float *>(epilogue.bias);
+            break;
+        case LLAISYS_DTYPE_BF16:
+            ep.bias = bias_to_f32<llaisys::bf16_t>(epilogue.bias, N);
+            break;
+        case LLAISYS_DTYPE_F16:
+            ep.bias = bias_to_f32<llaisys::fp16_t>(epilogue.bias, N);
+            break;
+        default:
+            EXCEPTION_UNSUPPORTED_DATATYPE(epilogue.bias_type);
+        }
+    }
+
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return linear_weight_<float>(out, in, weight, weight_scale, weight_zero, group, weight_type, weight_packed,
+                                    M, N, K, ep);
+    case LLAISYS_DTYPE_BF16:
+        return linear_weight_<llaisys::bf16_t>(out, in, weight, weight_scale, weight_zero, group, weight_type, weight_packed,
+                                    M, N, K, ep);
+    case LLAISYS_DTYPE_F16:
+        return linear_weight_<llaisys::fp16_t>(out, in, weight, weight_scale, weight_zero, group, weight_type, weight_packed,
+                                    M, N, K, ep);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+} // namespace llaisys::ops::cpu
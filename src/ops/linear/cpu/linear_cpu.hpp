@@ -1,34 +1,37 @@
 #pragma once
-#include "../../../utils.hpp"
+#include "llaisys.h"
+
+#include <cstddef>
 
 namespace llaisys::ops::cpu {
+// Work fused into the store of each output tile, applied to the F32 result in this order:
+//   Y = alpha * (X * dequant(W)^T) + b
+//   swiglu: W rows are interleaved (gate, up) pairs and Y[:, i] = silu(Y[:, 2i]) * Y[:, 2i + 1],
+//           so the output is [M, N / 2]
+//   out = Y + residual
+struct LinearEpilogue {
+    const std::byte *bias = nullptr; // [N] of `bias_type`
+    llaisysDataType_t bias_type = LLAISYS_DTYPE_F32;
+    const std::byte *residual = nullptr; // shaped like the output, of its type; may alias `out`
+    float alpha = 1.0f;
+    bool swiglu = false;
+};
 
-// Y = X * W^T + b
 // X: [M, K], W: [N, K], Y: [M, N]
-template <typename T>
-void linear(void *out_ptr, const void *in_ptr, const void *weight_ptr, const void *bias_ptr,
-            size_t M, size_t N, size_t K) {
-    auto *out = reinterpret_cast<T *>(out_ptr);
-    const auto *in = reinterpret_cast<const T *>(in_ptr);
-    const auto *weight = reinterpret_cast<const T *>(weight_ptr);
-    const auto *bias = reinterpret_cast<const T *>(bias_ptr);
+// X and Y are `type`, W is `weight_type`; accumulation is always F32.
+// Quantized weights are dequantized in registers:
+//   I8: W[n, k] * s[n], with `weight_scale` a [N] F32 array
+//   U8: packed q4 [N, K / 2] with `weight_scale` [N, K / group] F16 and optional
+//       `weight_zero` [N, K / group] U8, see quantize_cpu.hpp
+// With `weight_packed`, W is in the layout written by linear_pack_weight.
+void linear(std::byte *out, const std::byte *in, const std::byte *weight, const std::byte *weight_scale,
+            const std::byte *weight_zero, size_t group, llaisysDataType_t type, llaisysDataType_t weight_type,
+            bool weight_packed, size_t M, size_t N, size_t K, const LinearEpilogue &epilogue = {});
 
-    for (size_t m = 0; m < M; ++m) {
-        for (size_t n = 0; n < N; ++n) {
-            float sum = 0.0f;
-            for (size_t k = 0; k < K; ++k) {
-                float x_val = utils::cast<float>(in[m * K + k]);
-                float w_val = utils::cast<float>(weight[n * K + k]); 
-                sum += x_val * w_val;
-            }
-            
-            if (bias) {
-                sum += utils::cast<float>(bias[n]);
-            }
-            
-            out[m * N + n] = utils::cast<T>(sum);
-        }
-    }
+// Rows per panel of a prepacked weight: the register tile width of the GEMM micro-kernel.
+size_t linear_panel_rows();
+// Repacks a row-major F32/BF16/F16/I8 weight [N, K] into panels of linear_panel_rows() rows,
+// P[p][k][j] = W[p * rows + j][k], with the rows past N zero-filled. The GEMM tiles and the
+// GEMV then read W front to back without repacking it per call. Runs on the thread pool.
+void linear_pack_weight(std::byte *packed, const std::byte *weight, llaisysDataType_t weight_type, size_t N, size_t K);
 }
-
-} // namespace llaisys::ops::cpu
\ No newline at end of file
@@ -2,15 +2,66 @@
 #include "../../core/llaisys_core.hpp"
 #include "../../utils.hpp"
 #include "cpu/linear_cpu.hpp"
+#include "../quantize/op.hpp"
 
 namespace llaisys::ops {
-void linear(tensor_t out, tensor_t in, tensor_t weight, tensor_t bias) {
+size_t linear_weight_group(tensor_t weight, tensor_t weight_scale, tensor_t weight_zero, size_t N, size_t K) {
+    // 量化权重必须带有缩放，浮点权重不能带
+    size_t group = 0;
+    if (weight->dtype() == LLAISYS_DTYPE_I8) {
+        ASSERT(weight_scale != nullptr, "Linear: I8 weight requires weight_scale");
+        ASSERT(weight_scale->dtype() == LLAISYS_DTYPE_F32, "Linear: weight_scale must be F32");
+        ASSERT(weight_scale->numel() == N && weight_scale->isContiguous(),
+               "Linear: weight_scale must be a contiguous [N] tensor");
+        ASSERT(weight_zero == nullptr, "Linear: I8 weights have no zero points");
+    } else if (weight->dtype() == LLAISYS_DTYPE_U8) {
+        group = q4_group_size(weight, weight_scale, weight_zero, K);
+    } else {
+        ASSERT(weight_scale == nullptr && weight_zero == nullptr,
+               "Linear: weight_scale/weight_zero are only valid for quantized weights");
+    }
+    return group;
+}
+
+bool linear_weight_packed(tensor_t weight) {
+    if (weight->layout() == TensorLayout::PANEL_PACKED) {
+        // panel 宽度随编译时的 SIMD 选项变化，不同内核打包的权重不能混用
+        ASSERT(weight->panelRows() == cpu::linear_panel_rows(), "Linear: weight was packed for a different kernel");
+        return true;
+    }
+    ASSERT(weight->isContiguous(), "Linear: weight must be contiguous or packed.");
+    return false;
+}
+
+tensor_t linear_pack_weight(tensor_t weight) {
+    ASSERT(weight->ndim() == 2 && weight->isContiguous(), "LinearPackWeight: weight must be a contiguous 2D tensor");
+    size_t N = weight->shape()[0];
+    size_t K = weight->shape()[1];
+    auto packed = Tensor::createPacked(weight->shape(), weight->dtype(), cpu::linear_panel_rows(), weight->deviceType(),
+                                       weight->deviceId());
+
+    llaisys::core::context().setDevice(weight->deviceType(), weight->deviceId());
+
+    if (weight->deviceType() == LLAISYS_DEVICE_CPU) {
+        cpu::linear_pack_weight(packed->data(), weight->data(), weight->dtype(), N, K);
+        return packed;
+    } else {
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+
+void linear(tensor_t out, tensor_t in, tensor_t weight, tensor_t bias, tensor_t weight_scale, tensor_t weight_zero,
+            tensor_t residual, float alpha) {
     CHECK_SAME_DEVICE(out, in, weight);
     if (bias) CHECK_SAME_DEVICE(out, bias);
+    if (residual) CHECK_SAME_DEVICE(out, residual);
+    if (weight_scale) CHECK_SAME_DEVICE(out, weight_scale);
+    if (weight_zero) CHECK_SAME_DEVICE(out, weight_zero);
     
     // out: [M, N], in: [M, K], weight: [N, K]
     size_t N = weight->shape()[0];
-    size_t K = weight->shape()[1];
+    // q4 权重每字节存两个值
+    size_t K = weight->dtype() == LLAISYS_DTYPE_U8 ? weight->shape()[1] * 2 : weight->shape()[1];
     
     // 输入形状: [..., K]
     // 确保输入的最后一维等于权重的最后一维 (矩阵乘法 K 必须对齐)
@@ -18,21 +69,34 @@ void linear(tensor_t out, tensor_t in, tensor_t weight, tensor_t bias) {
     
     // M 是输入除了最后一维之外的所有维度之积
     size_t M = in->numel() / K;
-    // 【修改结束】
+    ASSERT(out->numel() == M * N, "Linear output shape must be [M, N]");
+    // 激活 (out/in)、权重与 bias 可以是不同的 dtype，例如 F32 激活 + BF16 权重
+    CHECK_SAME_DTYPE(out->dtype(), in->dtype());
+    ASSERT(out->isContiguous() && in->isContiguous(), "Linear: all tensors must be contiguous.");
+    bool weight_packed = linear_weight_packed(weight);
+    if (bias) ASSERT(bias->numel() == N && bias->isContiguous(), "Linear: bias must be a contiguous [N] tensor");
+    if (residual) {
+        CHECK_SAME_DTYPE(out->dtype(), residual->dtype());
+        ASSERT(residual->numel() == M * N && residual->isContiguous(), "Linear: residual must be a contiguous [M, N] tensor");
+    }
+
+    size_t group = linear_weight_group(weight, weight_scale, weight_zero, N, K);
 
     llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
 
+    // bias / residual / alpha 在写回输出时完成，不再额外遍历一遍 out
+    cpu::LinearEpilogue epilogue;
+    if (bias) {
+        epilogue.bias = bias->data();
+        epilogue.bias_type = bias->dtype();
+    }
+    epilogue.residual = residual ? residual->data() : nullptr;
+    epilogue.alpha = alpha;
+
     if (out->deviceType() == LLAISYS_DEVICE_CPU) {
-        switch (out->dtype()) {
-        case LLAISYS_DTYPE_F32:
-            return cpu::linear<float>(out->data(), in->data(), weight->data(), bias ? bias->data() : nullptr, M, N, K);
-        case LLAISYS_DTYPE_F16:
-            return cpu::linear<fp16_t>(out->data(), in->data(), weight->data(), bias ? bias->data() : nullptr, M, N, K);
-        case LLAISYS_DTYPE_BF16:
-            return cpu::linear<bf16_t>(out->data(), in->data(), weight->data(), bias ? bias->data() : nullptr, M, N, K);
-        default:
-            EXCEPTION_UNSUPPORTED_DATATYPE(out->dtype());
-        }
+        return cpu::linear(out->data(), in->data(), weight->data(), weight_scale ? weight_scale->data() : nullptr,
+                           weight_zero ? weight_zero->data() : nullptr, group, out->dtype(), weight->dtype(), weight_packed,
+                           M, N, K, epilogue);
     } else {
         EXCEPTION_UNSUPPORTED_DEVICE;
     }
@@ -3,5 +3,20 @@
 #include "../../tensor/tensor.hpp"
 
 namespace llaisys::ops {
-void linear(tensor_t out, tensor_t in, tensor_t weight, tensor_t bias);
+// out = alpha * (in * W^T) + bias + residual
+// 量化权重 (见 ops::quantize) 需要同时传入 weight_scale:
+//   I8 权重 [N, K]: weight_scale 为 [N] F32
+//   U8 (q4) 权重 [N, K / 2]: weight_scale 为 [N, K / group] F16, weight_zero 可选
+// residual 与 out 同形状同 dtype，可以就是 out 本身 (out += in * W^T)，用于直接累加到残差流
+void linear(tensor_t out, tensor_t in, tensor_t weight, tensor_t bias, tensor_t weight_scale = nullptr,
+            tensor_t weight_zero = nullptr, tensor_t residual = nullptr, float alpha = 1.0f);
+
+// 校验权重 [N, K] 的 scale / zero point 是否与其 dtype 匹配，返回 q4 的分组大小 (其余为 0)
+size_t linear_weight_group(tensor_t weight, tensor_t weight_scale, tensor_t weight_zero, size_t N, size_t K);
+// 校验权重的排布: 连续的行主序或本内核打包的 panel 格式，返回是否为后者
+bool linear_weight_packed(tensor_t weight);
+
+// 把行主序的 F32/BF16/F16/I8 权重 [N, K] 重排为 linear 内核的 panel 格式 (TensorLayout::PANEL_PACKED)，
+// 返回新张量。模型加载时做一次，之后每次 linear 都不必再打包权重。q4 权重不支持
+tensor_t linear_pack_weight(tensor_t weight);
 }
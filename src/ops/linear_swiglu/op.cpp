@@ -0,0 +1,39 @@
+#include "op.hpp"
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+#include "../linear/cpu/linear_cpu.hpp"
+#include "../linear/op.hpp"
+
+namespace llaisys::ops {
+void linear_swiglu(tensor_t out, tensor_t in, tensor_t weight, tensor_t weight_scale, tensor_t weight_zero) {
+    CHECK_SAME_DEVICE(out, in, weight);
+    if (weight_scale) CHECK_SAME_DEVICE(out, weight_scale);
+    if (weight_zero) CHECK_SAME_DEVICE(out, weight_zero);
+
+    size_t N = weight->shape()[0];
+    size_t K = weight->dtype() == LLAISYS_DTYPE_U8 ? weight->shape()[1] * 2 : weight->shape()[1];
+    ASSERT(N % 2 == 0, "LinearSwiGLU: weight must hold interleaved (gate, up) rows");
+    ASSERT(in->shape().back() == K, "LinearSwiGLU input dim must match weight input dim");
+
+    size_t M = in->numel() / K;
+    ASSERT(out->numel() == M * (N / 2), "LinearSwiGLU output shape must be [M, N / 2]");
+    CHECK_SAME_DTYPE(out->dtype(), in->dtype());
+    ASSERT(out->isContiguous() && in->isContiguous(), "LinearSwiGLU: all tensors must be contiguous.");
+    bool weight_packed = linear_weight_packed(weight);
+    size_t group = linear_weight_group(weight, weight_scale, weight_zero, N, K);
+
+    llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
+
+    // 与 linear 共用 GEMM/GEMV 内核，silu(gate) * up 在写回输出时完成
+    cpu::LinearEpilogue epilogue;
+    epilogue.swiglu = true;
+
+    if (out->deviceType() == LLAISYS_DEVICE_CPU) {
+        return cpu::linear(out->data(), in->data(), weight->data(), weight_scale ? weight_scale->data() : nullptr,
+                           weight_zero ? weight_zero->data() : nullptr, group, out->dtype(), weight->dtype(), weight_packed,
+                           M, N, K, epilogue);
+    } else {
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+} // namespace llaisys::ops
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "../../tensor/tensor.hpp"
+
+namespace llaisys::ops {
+// out = swiglu(gate = in * W_gate^T, up = in * W_up^T)，gate/up 不落到内存
+// weight: [2 * I, K]，按行交错存放 gate 与 up: 第 2i 行为 W_gate[i]，第 2i + 1 行为 W_up[i]
+// out: [M, I]，in: [M, K]；量化权重的 weight_scale / weight_zero 与 ops::linear 相同
+void linear_swiglu(tensor_t out, tensor_t in, tensor_t weight, tensor_t weight_scale = nullptr,
+                   tensor_t weight_zero = nullptr);
+}
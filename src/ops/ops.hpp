@@ -4,9 +4,14 @@
 
 // 包含所有算子的头文件
 #include "add/op.hpp"
+#include "add_rms_norm/op.hpp"
 #include "argmax/op.hpp"
 #include "embedding/op.hpp"
+#include "kv_append/op.hpp"
 #include "linear/op.hpp"
+#include "linear_swiglu/op.hpp"
+#include "paged_attention/op.hpp"
+#include "quantize/op.hpp"
 #include "rms_norm/op.hpp"
 #include "rope/op.hpp"
 #include "self_attention/op.hpp"
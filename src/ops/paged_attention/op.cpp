@@ -0,0 +1,71 @@
+#include "op.hpp"
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+#include "../self_attention/cpu/self_attention_cpu.hpp"
+
+namespace llaisys::ops {
+void paged_attention(tensor_t attn_val, tensor_t q, tensor_t k_cache, tensor_t v_cache, tensor_t k_scale,
+                     tensor_t v_scale, tensor_t block_table, size_t total_len, float scale) {
+    CHECK_SAME_DEVICE(attn_val, q, k_cache);
+    CHECK_SAME_DEVICE(v_cache, block_table, q);
+    CHECK_SAME_DTYPE(attn_val->dtype(), q->dtype());
+    CHECK_SAME_DTYPE(k_cache->dtype(), v_cache->dtype());
+    ASSERT(block_table->dtype() == LLAISYS_DTYPE_I32, "PagedAttention: block_table must be I32");
+    ASSERT(q->ndim() == 3 && k_cache->ndim() == 4 && v_cache->ndim() == 4,
+           "PagedAttention: q must be 3D and the caches 4D");
+
+    size_t seq_len = q->shape()[0];
+    size_t n_head = q->shape()[1];
+    size_t head_dim = q->shape()[2];
+
+    size_t num_blocks = k_cache->shape()[0];
+    size_t block_size = k_cache->shape()[1];
+    size_t n_kv_head = k_cache->shape()[2];
+    size_t v_head_dim = v_cache->shape()[3];
+
+    ASSERT(k_cache->shape()[3] == head_dim, "PagedAttention: q and k must share the head dim");
+    ASSERT(v_cache->shape()[0] == num_blocks && v_cache->shape()[1] == block_size && v_cache->shape()[2] == n_kv_head,
+           "PagedAttention: k and v caches must match");
+    ASSERT(attn_val->numel() == seq_len * n_head * v_head_dim, "PagedAttention: attn_val must be [seqlen, nhead, dv]");
+    ASSERT(n_head % n_kv_head == 0, "PagedAttention: nhead must be a multiple of nkvhead");
+    ASSERT(total_len >= seq_len, "PagedAttention: kv must cover every query position");
+    ASSERT(attn_val->isContiguous() && q->isContiguous() && k_cache->isContiguous() && v_cache->isContiguous() &&
+               block_table->isContiguous(),
+           "PagedAttention: all tensors must be contiguous");
+
+    // INT8 cache 每个 (token, kv head) 一个 F32 scale，形状为 [num_blocks, block_size, nkvhead]
+    bool quantized = k_cache->dtype() == LLAISYS_DTYPE_I8;
+    if (quantized) {
+        ASSERT(k_scale && v_scale, "PagedAttention: an INT8 cache needs k_scale and v_scale");
+        CHECK_SAME_DEVICE(k_scale, v_scale, q);
+        CHECK_SAME_DTYPE(k_scale->dtype(), v_scale->dtype(), LLAISYS_DTYPE_F32);
+        CHECK_SAME_SHAPE(k_scale->shape(), v_scale->shape());
+        ASSERT(k_scale->ndim() == 3 && k_scale->shape()[0] == num_blocks && k_scale->shape()[1] == block_size &&
+                   k_scale->shape()[2] == n_kv_head,
+               "PagedAttention: scales must be [num_blocks, block_size, nkvhead]");
+        ASSERT(k_scale->isContiguous() && v_scale->isContiguous(), "PagedAttention: scales must be contiguous");
+    } else {
+        ASSERT(!k_scale && !v_scale, "PagedAttention: only an INT8 cache takes scales");
+    }
+
+    // block table 在 host 可读 (CPU)，越界的块号会读到池外，这里统一检查
+    size_t used_blocks = (total_len + block_size - 1) / block_size;
+    ASSERT(block_table->numel() >= used_blocks, "PagedAttention: block_table does not cover total_len");
+
+    llaisys::core::context().setDevice(attn_val->deviceType(), attn_val->deviceId());
+
+    if (attn_val->deviceType() == LLAISYS_DEVICE_CPU) {
+        const auto *table = reinterpret_cast<const int32_t *>(block_table->data());
+        for (size_t b = 0; b < used_blocks; ++b) {
+            ASSERT(table[b] >= 0 && (size_t)table[b] < num_blocks, "PagedAttention: block id out of range");
+        }
+        return cpu::self_attention(attn_val->data(), q->data(), k_cache->data(), v_cache->data(), attn_val->dtype(),
+                                   k_cache->dtype(), scale, seq_len, total_len, n_head, n_kv_head, head_dim,
+                                   v_head_dim, table, block_size,
+                                   quantized ? reinterpret_cast<const float *>(k_scale->data()) : nullptr,
+                                   quantized ? reinterpret_cast<const float *>(v_scale->data()) : nullptr);
+    } else {
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+} // namespace llaisys::ops
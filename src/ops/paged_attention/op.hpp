@@ -0,0 +1,14 @@
+#pragma once
+
+#include "../../tensor/tensor.hpp"
+
+namespace llaisys::ops {
+// 与 self_attention 相同的因果 (GQA) 注意力，但 K/V 从分页 cache 中经 block table 读取:
+// k_cache: [num_blocks, block_size, nkvhead, d]，v_cache: [num_blocks, block_size, nkvhead, dv]
+// block_table: I32 [>= ceil(total_len / block_size)]，第 t 个 key 位于 block_table[t / block_size] 块的
+// 第 t % block_size 行；q: [seqlen, nhead, d] 对应序列最后 seqlen 个位置，attn_val: [seqlen, nhead, dv]
+// cache 的类型可与 q 不同 (F32/BF16/F16)，在内核中转换为 F32；INT8 cache 另需 F32 的
+// k_scale / v_scale [num_blocks, block_size, nkvhead] (见 kv_append)，非 INT8 时传 nullptr
+void paged_attention(tensor_t attn_val, tensor_t q, tensor_t k_cache, tensor_t v_cache, tensor_t k_scale,
+                     tensor_t v_scale, tensor_t block_table, size_t total_len, float scale);
+}
@@ -0,0 +1,104 @@
+#include "quantize_cpu.hpp"
+
+#include "../../../core/thread_pool/thread_pool.hpp"
+#include "../../../utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+template <typename T>
+void quantize_(int8_t *out, float *scale, const T *in, size_t N, size_t K) {
+    llaisys::core::parallel_for(N, 1, [&](size_t n0, size_t n1) {
+        for (size_t n = n0; n < n1; n++) {
+            const T *row = in + n * K;
+            float amax = 0.0f;
+            for (size_t k = 0; k < K; k++) {
+                amax = std::max(amax, std::fabs(llaisys::utils::cast<float>(row[k])));
+            }
+            // An all-zero row keeps scale 0 and quantizes to zeros.
+            float s = amax / 127.0f;
+            float inv = amax > 0.0f ? 127.0f / amax : 0.0f;
+            for (size_t k = 0; k < K; k++) {
+                float q = std::nearbyint(llaisys::utils::cast<float>(row[k]) * inv);
+                out[n * K + k] = static_cast<int8_t>(std::clamp(q, -127.0f, 127.0f));
+            }
+            scale[n] = s;
+        }
+    });
+}
+
+template <typename T>
+void quantize_q4_(uint8_t *out, llaisys::fp16_t *scale, uint8_t *zero, const T *in, size_t N, size_t K, size_t group) {
+    using llaisys::ops::cpu::Q4_BLOCK;
+    size_t groups = K / group;
+    llaisys::core::parallel_for(N, 1, [&](size_t n0, size_t n1) {
+        for (size_t n = n0; n < n1; n++) {
+            const T *row = in + n * K;
+            uint8_t *q_row = out + n * (K / 2);
+            std::memset(q_row, 0, K / 2);
+            for (size_t g = 0; g < groups; g++) {
+                float lo = 0.0f, hi = 0.0f;
+                for (size_t k = g * group; k < (g + 1) * group; k++) {
+                    float w = llaisys::utils::cast<float>(row[k]);
+                    lo = std::min(lo, w);
+                    hi = std::max(hi, w);
+                }
+                float s;
+                float z;
+                if (zero) {
+                    s = (hi - lo) / 15.0f;
+                    z = s > 0.0f ? std::clamp(std::nearbyint(-lo / s), 0.0f, 15.0f) : 0.0f;
+                    zero[n * groups + g] = static_cast<uint8_t>(z);
+                } else {
+                    s = std::max(-lo, hi) / 7.0f;
+                    z = llaisys::ops::cpu::Q4_SYMMETRIC_ZERO;
+                }
+                // Quantize against the F16-rounded scale the kernels will see.
+                scale[n * groups + g] = llaisys::utils::cast<llaisys::fp16_t>(s);
+                s = llaisys::utils::cast<float>(scale[n * groups + g]);
+                float inv = s > 0.0f ? 1.0f / s : 0.0f;
+                for (size_t k = g * group; k < (g + 1) * group; k++) {
+                    float q = std::nearbyint(llaisys::utils::cast<float>(row[k]) * inv) + z;
+                    uint8_t v = static_cast<uint8_t>(std::clamp(q, 0.0f, 15.0f));
+                    size_t byte = (k / Q4_BLOCK) * (Q4_BLOCK / 2) + (k % (Q4_BLOCK / 2));
+                    q_row[byte] |= (k % Q4_BLOCK) < Q4_BLOCK / 2 ? v : static_cast<uint8_t>(v << 4);
+                }
+            }
+        }
+    });
+}
+
+namespace llaisys::ops::cpu {
+void quantize(std::byte *out, std::byte *scale, const std::byte *in, llaisysDataType_t type, size_t N, size_t K) {
+    auto *q = reinterpret_cast<int8_t *>(out);
+    auto *s = reinterpret_cast<float *>(scale);
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return quantize_(q, s, reinterpret_cast<const float *>(in), N, K);
+    case LLAISYS_DTYPE_BF16:
+        return quantize_(q, s, reinterpret_cast<const llaisys::bf16_t *>(in), N, K);
+    case LLAISYS_DTYPE_F16:
+        return quantize_(q, s, reinterpret_cast<const llaisys::fp16_t *>(in), N, K);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+
+void quantize_q4(std::byte *out, std::byte *scale, std::byte *zero, const std::byte *in, llaisysDataType_t type,
+                 size_t N, size_t K, size_t group) {
+    auto *q = reinterpret_cast<uint8_t *>(out);
+    auto *s = reinterpret_cast<llaisys::fp16_t *>(scale);
+    auto *z = reinterpret_cast<uint8_t *>(zero);
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return quantize_q4_(q, s, z, reinterpret_cast<const float *>(in), N, K, group);
+    case LLAISYS_DTYPE_BF16:
+        return quantize_q4_(q, s, z, reinterpret_cast<const llaisys::bf16_t *>(in), N, K, group);
+    case LLAISYS_DTYPE_F16:
+        return quantize_q4_(q, s, z, reinterpret_cast<const llaisys::fp16_t *>(in), N, K, group);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+} // namespace llaisys::ops::cpu
@@ -0,0 +1,29 @@
+#pragma once
+#include "llaisys.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace llaisys::ops::cpu {
+// Values per q4 block. A block is packed into 16 bytes: byte i holds value i in its
+// low nibble and value i + 16 in its high nibble (see utils::simd::load_q4).
+constexpr size_t Q4_BLOCK = 32;
+// Zero point of symmetric q4 groups, which carry no explicit zero point.
+constexpr uint8_t Q4_SYMMETRIC_ZERO = 8;
+
+// Unsigned 4-bit value k (0..15) of a packed q4 row.
+inline uint8_t q4_get(const uint8_t *row, size_t k) {
+    const uint8_t byte = row[(k / Q4_BLOCK) * (Q4_BLOCK / 2) + (k % (Q4_BLOCK / 2))];
+    return (k % Q4_BLOCK) < Q4_BLOCK / 2 ? (byte & 0x0F) : (byte >> 4);
+}
+
+// Symmetric per-row INT8: scale[n] = max|in[n, :]| / 127, out = round(in / scale).
+void quantize(std::byte *out, std::byte *scale, const std::byte *in, llaisysDataType_t type, size_t N, size_t K);
+
+// Group-wise 4-bit: each run of `group` values in a row shares an F16 scale.
+// out: [N, K / 2] packed q4, scale: [N, K / group] F16, zero: [N, K / group] U8 or null.
+// With zero points w ≈ (q - zero) * scale over [min, max] of the group; without,
+// w ≈ (q - 8) * scale with scale = max|w| / 7.
+void quantize_q4(std::byte *out, std::byte *scale, std::byte *zero, const std::byte *in, llaisysDataType_t type,
+                 size_t N, size_t K, size_t group);
+} // namespace llaisys::ops::cpu
@@ -0,0 +1,63 @@
+#include "op.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+#include "cpu/quantize_cpu.hpp"
+
+namespace llaisys::ops {
+size_t q4_group_size(tensor_t weight, tensor_t scale, tensor_t zero, size_t K) {
+    ASSERT(weight->dtype() == LLAISYS_DTYPE_U8 && weight->ndim() == 2 && weight->shape()[1] * 2 == K,
+           "Q4: packed weight must be a U8 [N, K / 2] tensor");
+    ASSERT(scale != nullptr && scale->dtype() == LLAISYS_DTYPE_F16 && scale->ndim() == 2,
+           "Q4: scale must be a F16 [N, K / group] tensor");
+    ASSERT(scale->shape()[0] == weight->shape()[0] && scale->shape()[1] > 0 && K % scale->shape()[1] == 0,
+           "Q4: scale shape does not match the weight");
+    size_t group = K / scale->shape()[1];
+    ASSERT(group % cpu::Q4_BLOCK == 0, "Q4: group size must be a multiple of 32");
+    if (zero) {
+        ASSERT(zero->dtype() == LLAISYS_DTYPE_U8, "Q4: zero points must be U8");
+        CHECK_SAME_SHAPE(zero->shape(), scale->shape());
+        ASSERT(zero->isContiguous(), "Q4: zero points must be contiguous");
+    }
+    ASSERT(weight->isContiguous() && scale->isContiguous(), "Q4: weight and scale must be contiguous");
+    return group;
+}
+
+void quantize(tensor_t out, tensor_t scale, tensor_t in, tensor_t zero) {
+    CHECK_SAME_DEVICE(out, scale, in);
+    if (zero) CHECK_SAME_DEVICE(out, zero);
+    ASSERT(in->ndim() == 2, "Quantize: input must be a 2D [N, K] tensor");
+    ASSERT(out->isContiguous() && scale->isContiguous() && in->isContiguous(), "Quantize: all tensors must be contiguous.");
+    size_t N = in->shape()[0];
+    size_t K = in->shape()[1];
+
+    llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
+
+    if (out->dtype() == LLAISYS_DTYPE_I8) {
+        CHECK_SAME_SHAPE(out->shape(), in->shape());
+        ASSERT(scale->dtype() == LLAISYS_DTYPE_F32, "Quantize: scale must be F32");
+        ASSERT(scale->numel() == N, "Quantize: scale must have one entry per row");
+        ASSERT(zero == nullptr, "Quantize: INT8 quantization is symmetric and has no zero points");
+    } else {
+        ASSERT(out->dtype() == LLAISYS_DTYPE_U8, "Quantize: output must be I8 or U8 (packed q4)");
+        q4_group_size(out, scale, zero, K);
+    }
+
+    switch (out->deviceType()) {
+    case LLAISYS_DEVICE_CPU:
+        if (out->dtype() == LLAISYS_DTYPE_I8) {
+            return cpu::quantize(out->data(), scale->data(), in->data(), in->dtype(), N, K);
+        }
+        return cpu::quantize_q4(out->data(), scale->data(), zero ? zero->data() : nullptr, in->data(), in->dtype(),
+                                N, K, K / scale->shape()[1]);
+#ifdef ENABLE_NVIDIA_API
+    case LLAISYS_DEVICE_NVIDIA:
+        TO_BE_IMPLEMENTED();
+        return;
+#endif
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+} // namespace llaisys::ops
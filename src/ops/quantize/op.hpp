@@ -0,0 +1,17 @@
+#pragma once
+
+#include "../../tensor/tensor.hpp"
+
+namespace llaisys::ops {
+// 权重量化，输出格式由 out 的 dtype 决定:
+//   I8: 每通道对称量化, in [N, K] -> out [N, K], scale [N] F32, zero 必须为空
+//       in[n, k] ≈ out[n, k] * scale[n]
+//   U8: 4-bit 分组量化 (q4), 每字节两个值, in [N, K] -> out [N, K / 2],
+//       scale [N, K / group] F16, zero 为空 (对称) 或 [N, K / group] U8 (非对称)
+//       in[n, k] ≈ (q[n, k] - zero) * scale[n, k / group], 对称时 zero = 8
+// in 可以是 F32/BF16/F16
+void quantize(tensor_t out, tensor_t scale, tensor_t in, tensor_t zero = nullptr);
+
+// 校验 q4 权重 [N, K / 2] 及其 scale/zero，返回分组大小 (32 的倍数)
+size_t q4_group_size(tensor_t weight, tensor_t scale, tensor_t zero, size_t K);
+} // namespace llaisys::ops
@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include "../../../core/thread_pool/thread_pool.hpp"
 #include "../../../utils.hpp"
 
 namespace llaisys::ops::cpu {
@@ -33,7 +34,18 @@ void rearrange(void *out_ptr, const void *in_ptr,
     auto *out = reinterpret_cast<T *>(out_ptr);
     const auto *in = reinterpret_cast<const T *>(in_ptr);
     
-    copy_recursive(out, in, shape, out_strides, in_strides, 0, 0, 0);
+    if (shape.empty()) {
+        copy_recursive(out, in, shape, out_strides, in_strides, 0, 0, 0);
+        return;
+    }
+
+    // 按最外层维度并行，每个切片内部仍然递归复制
+    core::parallel_for(shape[0], 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            copy_recursive(out, in, shape, out_strides, in_strides, 1,
+                           i * out_strides[0], i * in_strides[0]);
+        }
+    });
 }
 
 } // namespace llaisys::ops::cpu
\ No newline at end of file
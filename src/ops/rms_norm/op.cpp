@@ -4,23 +4,42 @@
 #include "cpu/rms_norm_cpu.hpp"
 
 namespace llaisys::ops {
+namespace {
+template <typename T>
+void rms_norm_cpu(tensor_t out, tensor_t in, tensor_t weight, float eps, size_t num_rows, size_t dim) {
+    switch (weight->dtype()) {
+    case LLAISYS_DTYPE_F32:
+        return cpu::rms_norm<T, float>(out->data(), in->data(), weight->data(), eps, num_rows, dim);
+    case LLAISYS_DTYPE_F16:
+        return cpu::rms_norm<T, fp16_t>(out->data(), in->data(), weight->data(), eps, num_rows, dim);
+    case LLAISYS_DTYPE_BF16:
+        return cpu::rms_norm<T, bf16_t>(out->data(), in->data(), weight->data(), eps, num_rows, dim);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(weight->dtype());
+    }
+}
+} // namespace
+
 void rms_norm(tensor_t out, tensor_t in, tensor_t weight, float eps) {
     CHECK_SAME_DEVICE(out, in, weight);
+    // weight 允许与激活不同的 dtype (例如保持 checkpoint 的 BF16)
+    CHECK_SAME_DTYPE(out->dtype(), in->dtype());
     
     // in: [rows, dim]
     size_t dim = in->shape().back();
     size_t num_rows = in->numel() / dim;
+    ASSERT(weight->numel() == dim, "RmsNorm: weight size must match the last dim of input");
 
     llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
 
     if (out->deviceType() == LLAISYS_DEVICE_CPU) {
         switch (out->dtype()) {
         case LLAISYS_DTYPE_F32:
-            return cpu::rms_norm<float>(out->data(), in->data(), weight->data(), eps, num_rows, dim);
+            return rms_norm_cpu<float>(out, in, weight, eps, num_rows, dim);
         case LLAISYS_DTYPE_F16:
-            return cpu::rms_norm<fp16_t>(out->data(), in->data(), weight->data(), eps, num_rows, dim);
+            return rms_norm_cpu<fp16_t>(out, in, weight, eps, num_rows, dim);
         case LLAISYS_DTYPE_BF16:
-            return cpu::rms_norm<bf16_t>(out->data(), in->data(), weight->data(), eps, num_rows, dim);
+            return rms_norm_cpu<bf16_t>(out, in, weight, eps, num_rows, dim);
         default:
             EXCEPTION_UNSUPPORTED_DATATYPE(out->dtype());
         }
@@ -28,4 +47,4 @@ void rms_norm(tensor_t out, tensor_t in, tensor_t weight, float eps) {
         EXCEPTION_UNSUPPORTED_DEVICE;
     }
 }
-} // namespace llaisys::ops
\ No newline at end of file
+} // namespace llaisys::ops
@@ -0,0 +1,93 @@
+#include "rope_cpu.hpp"
+
+#include "../../../core/thread_pool/thread_pool.hpp"
+#include "../../../utils.hpp"
+#include "rope_rotate.hpp"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+// theta^(-2j / head_dim) for j < head_dim / 2, kept per thread for the last (theta, head_dim).
+const double *inv_freqs(float theta, size_t head_dim) {
+    thread_local std::vector<double> freqs;
+    thread_local float cached_theta = 0.0f;
+    if (cached_theta != theta || freqs.size() != head_dim / 2) {
+        freqs.resize(head_dim / 2);
+        for (size_t j = 0; j < freqs.size(); j++) {
+            freqs[j] = std::pow(static_cast<double>(theta), -2.0 * static_cast<double>(j) / static_cast<double>(head_dim));
+        }
+        cached_theta = theta;
+    }
+    return freqs.data();
+}
+
+// cos followed by sin of every frequency at one position. The angle is formed in double to
+// match the reference, then each value is rounded to float.
+void rope_row(float *row, int64_t pos, float theta, size_t head_dim) {
+    const size_t half_dim = head_dim / 2;
+    const double *freqs = inv_freqs(theta, head_dim);
+    for (size_t j = 0; j < half_dim; j++) {
+        double angle = static_cast<double>(pos) * freqs[j];
+        row[j] = static_cast<float>(std::cos(angle));
+        row[half_dim + j] = static_cast<float>(std::sin(angle));
+    }
+}
+
+template <typename T>
+void rope_(T *out, const T *in, const int64_t *pos_ids, float theta, const float *table, size_t seq_len,
+           size_t n_heads, size_t head_dim, size_t out_stride, size_t in_stride) {
+    const size_t half_dim = head_dim / 2;
+    // Each (token, head) is independent; without a table the cos/sin row is computed once per
+    // token of a chunk instead of once per head.
+    llaisys::core::parallel_for(seq_len * n_heads, 4, [&](size_t begin, size_t end) {
+        thread_local std::vector<float> scratch;
+        const float *row = nullptr;
+        size_t row_token = SIZE_MAX;
+        for (size_t pair = begin; pair < end; ++pair) {
+            size_t i = pair / n_heads;
+            size_t h = pair % n_heads;
+            if (i != row_token) {
+                if (table) {
+                    row = table + static_cast<size_t>(pos_ids[i]) * head_dim;
+                } else {
+                    scratch.resize(head_dim);
+                    rope_row(scratch.data(), pos_ids[i], theta, head_dim);
+                    row = scratch.data();
+                }
+                row_token = i;
+            }
+            llaisys::ops::cpu::rope_rotate(out + i * out_stride + h * head_dim, in + i * in_stride + h * head_dim,
+                                           row, row + half_dim, half_dim);
+        }
+    });
+}
+} // namespace
+
+namespace llaisys::ops::cpu {
+void rope_table(float *table, float theta, size_t max_pos, size_t head_dim) {
+    core::parallel_for(max_pos, 16, [&](size_t begin, size_t end) {
+        for (size_t pos = begin; pos < end; pos++) {
+            rope_row(table + pos * head_dim, static_cast<int64_t>(pos), theta, head_dim);
+        }
+    });
+}
+
+void rope(std::byte *out, const std::byte *in, llaisysDataType_t type, const int64_t *pos_ids, float theta,
+          const float *table, size_t seq_len, size_t n_heads, size_t head_dim, size_t out_stride,
+          size_t in_stride) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return rope_(reinterpret_cast<float *>(out), reinterpret_cast<const float *>(in), pos_ids, theta, table,
+                     seq_len, n_heads, head_dim, out_stride, in_stride);
+    case LLAISYS_DTYPE_BF16:
+        return rope_(reinterpret_cast<bf16_t *>(out), reinterpret_cast<const bf16_t *>(in), pos_ids, theta, table,
+                     seq_len, n_heads, head_dim, out_stride, in_stride);
+    case LLAISYS_DTYPE_F16:
+        return rope_(reinterpret_cast<fp16_t *>(out), reinterpret_cast<const fp16_t *>(in), pos_ids, theta, table,
+                     seq_len, n_heads, head_dim, out_stride, in_stride);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+} // namespace llaisys::ops::cpu
@@ -0,0 +1,51 @@
+#pragma once
+#include "../../../utils.hpp"
+#include "../../../utils/simd.hpp"
+
+#include <cstddef>
+#include <type_traits>
+
+// Row rotation shared by the CPU kernels that apply RoPE (rope, rope_kv_append). Only include
+// it from cpu kernel translation units, like utils/simd.hpp.
+//
+// The kernels are built with -mfma, and gcc / clang would otherwise fuse the rotation's
+// multiplies and adds, which rounds differently from the reference.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace llaisys::ops::cpu {
+// out_a = a * cos - b * sin, out_b = b * cos + a * sin over the two halves of one head, with
+// separately rounded multiplies and adds in every lane. out may alias in.
+template <typename T>
+void rope_rotate(T *out, const T *in, const float *cos, const float *sin, size_t half_dim) {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+    namespace simd = llaisys::utils::simd;
+    size_t j = 0;
+    if constexpr (std::is_same_v<T, float>) {
+        for (; j + simd::width <= half_dim; j += simd::width) {
+            simd::vfloat a = simd::load(in + j);
+            simd::vfloat b = simd::load(in + half_dim + j);
+            simd::vfloat c = simd::load(cos + j);
+            simd::vfloat s = simd::load(sin + j);
+            simd::store(out + j, simd::sub(simd::mul(a, c), simd::mul(b, s)));
+            simd::store(out + half_dim + j, simd::add(simd::mul(b, c), simd::mul(a, s)));
+        }
+    }
+    for (; j < half_dim; j++) {
+        float a = llaisys::utils::cast<float>(in[j]);
+        float b = llaisys::utils::cast<float>(in[half_dim + j]);
+        float out_a = a * cos[j] - b * sin[j];
+        float out_b = b * cos[j] + a * sin[j];
+        out[j] = llaisys::utils::cast<T>(out_a);
+        out[half_dim + j] = llaisys::utils::cast<T>(out_b);
+    }
+}
+} // namespace llaisys::ops::cpu
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC pop_options
+#endif
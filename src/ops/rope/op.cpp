@@ -4,29 +4,63 @@
 #include "cpu/rope_cpu.hpp"
 
 namespace llaisys::ops {
-void rope(tensor_t out, tensor_t in, tensor_t pos_ids, float theta) {
+void rope(tensor_t out, tensor_t in, tensor_t pos_ids, float theta, tensor_t table) {
     CHECK_SAME_DEVICE(out, in, pos_ids);
     ASSERT(pos_ids->dtype() == LLAISYS_DTYPE_I64, "RoPE: pos_ids must be I64");
     
+    CHECK_SAME_DTYPE(out->dtype(), in->dtype());
+    CHECK_SAME_SHAPE(out->shape(), in->shape());
+    
     // shape: [seqlen, nhead, head_dim]
     size_t seq_len = in->shape()[0];
     size_t n_heads = in->shape()[1];
     size_t head_dim = in->shape()[2];
+    ASSERT(pos_ids->numel() == seq_len, "RoPE: pos_ids must hold one position per token");
+
+    // 每个 token 内 [nhead, head_dim] 必须连续，token 之间可以有间隔
+    // (例如直接读取融合 QKV 输出中的 q/k 列)
+    auto token_stride = [&](const tensor_t &t) {
+        ASSERT(t->strides()[2] == 1 && t->strides()[1] == (ptrdiff_t)head_dim,
+               "RoPE: heads of a token must be contiguous");
+        return (size_t)t->strides()[0];
+    };
+    size_t out_stride = token_stride(out);
+    size_t in_stride = token_stride(in);
+
+    const float *table_ptr = nullptr;
+    if (table) {
+        CHECK_SAME_DEVICE(out, table);
+        ASSERT(table->dtype() == LLAISYS_DTYPE_F32 && table->isContiguous(), "RoPE: table must be contiguous F32");
+        ASSERT(table->ndim() == 3 && table->shape()[1] == 2 && table->shape()[2] == head_dim / 2,
+               "RoPE: table must be [max_pos, 2, head_dim / 2]");
+        table_ptr = reinterpret_cast<const float *>(table->data());
+    }
 
     llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
 
     if (out->deviceType() == LLAISYS_DEVICE_CPU) {
         const int64_t* pos_ptr = reinterpret_cast<const int64_t*>(pos_ids->data());
-        switch (out->dtype()) {
-        case LLAISYS_DTYPE_F32:
-            return cpu::rope<float>(out->data(), in->data(), pos_ptr, theta, seq_len, n_heads, head_dim);
-        case LLAISYS_DTYPE_F16:
-            return cpu::rope<fp16_t>(out->data(), in->data(), pos_ptr, theta, seq_len, n_heads, head_dim);
-        case LLAISYS_DTYPE_BF16:
-            return cpu::rope<bf16_t>(out->data(), in->data(), pos_ptr, theta, seq_len, n_heads, head_dim);
-        default:
-            EXCEPTION_UNSUPPORTED_DATATYPE(out->dtype());
+        // 查表前确认位置都在表内
+        for (size_t i = 0; table && i < seq_len; ++i) {
+            ASSERT(pos_ptr[i] >= 0 && (size_t)pos_ptr[i] < table->shape()[0], "RoPE: position outside the table");
         }
+        return cpu::rope(out->data(), in->data(), out->dtype(), pos_ptr, theta, table_ptr, seq_len, n_heads,
+                         head_dim, out_stride, in_stride);
+    } else {
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+
+void rope_table(tensor_t table, float theta) {
+    ASSERT(table->dtype() == LLAISYS_DTYPE_F32 && table->isContiguous(), "RoPE: table must be contiguous F32");
+    ASSERT(table->ndim() == 3 && table->shape()[1] == 2, "RoPE: table must be [max_pos, 2, head_dim / 2]");
+    size_t max_pos = table->shape()[0];
+    size_t head_dim = table->shape()[2] * 2;
+
+    llaisys::core::context().setDevice(table->deviceType(), table->deviceId());
+
+    if (table->deviceType() == LLAISYS_DEVICE_CPU) {
+        return cpu::rope_table(reinterpret_cast<float *>(table->data()), theta, max_pos, head_dim);
     } else {
         EXCEPTION_UNSUPPORTED_DEVICE;
     }
@@ -3,5 +3,8 @@
 #include "../../tensor/tensor.hpp"
 
 namespace llaisys::ops {
-void rope(tensor_t out, tensor_t in, tensor_t pos_ids, float theta);
+// table 为 rope_table 预先算好的 cos/sin 时直接查表 (theta 不再使用)，结果与不带表时逐位相同
+void rope(tensor_t out, tensor_t in, tensor_t pos_ids, float theta, tensor_t table = nullptr);
+// 填充 F32 table [max_pos, 2, head_dim / 2]: 第 p 行为位置 p 各频率的 cos，随后是 sin
+void rope_table(tensor_t table, float theta);
 }
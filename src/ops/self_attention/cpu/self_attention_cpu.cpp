@@ -0,0 +1,342 @@
+#include "self_attention_cpu.hpp"
+
+#include "../../../core/thread_pool/thread_pool.hpp"
+#include "../../../utils.hpp"
+#include "../../../utils/simd_math.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace {
+namespace simd = llaisys::utils::simd;
+
+// Keys per K/V tile: the tile's K and V rows of one kv head stay in L1 while every query
+// row of a block is scored against them.
+constexpr size_t KV_BLOCK = 32;
+static_assert(KV_BLOCK % simd::width == 0, "softmax runs on whole vectors of a tile");
+// Query rows sharing each K/V tile. A row is one (query, head) pair; a block holds all heads
+// of a GQA group for as many queries as fit, so K/V are read once per group instead of once
+// per query head, and prefill also reuses them across queries.
+constexpr size_t ROW_BLOCK = 16;
+// Vectors of the output row held in registers while a tile of V rows is accumulated.
+constexpr size_t V_TILE = 4;
+// Split-K over the keys: aim for this many independent tasks per call, but never cut the
+// keys into slices shorter than MIN_SPLIT_LEN, below which the merge costs more than it saves.
+constexpr size_t TARGET_TASKS = 64;
+constexpr size_t MIN_SPLIT_LEN = 256;
+
+template <typename T>
+float dot(const float *q, const T *k, size_t n) {
+    simd::vfloat acc0 = simd::zero();
+    simd::vfloat acc1 = simd::zero();
+    size_t d = 0;
+    for (; d + 2 * simd::width <= n; d += 2 * simd::width) {
+        acc0 = simd::fmadd(simd::load(q + d), simd::load(k + d), acc0);
+        acc1 = simd::fmadd(simd::load(q + d + simd::width), simd::load(k + d + simd::width), acc1);
+    }
+    for (; d + simd::width <= n; d += simd::width) {
+        acc0 = simd::fmadd(simd::load(q + d), simd::load(k + d), acc0);
+    }
+    float sum = simd::reduce_add(simd::add(acc0, acc1));
+    for (; d < n; d++) {
+        sum += q[d] * llaisys::utils::cast<float>(k[d]);
+    }
+    return sum;
+}
+
+// acc = acc * corr + sum_t p[t] * v[t] over `count` rows of v.
+template <typename T>
+void accumulate(float *acc, float corr, const float *p, const T *const *v, size_t count, size_t dv) {
+    const simd::vfloat c = simd::set1(corr);
+    size_t d = 0;
+    for (; d + V_TILE * simd::width <= dv; d += V_TILE * simd::width) {
+        simd::vfloat a[V_TILE];
+        for (size_t j = 0; j < V_TILE; j++) {
+            a[j] = simd::mul(simd::load(acc + d + j * simd::width), c);
+        }
+        for (size_t t = 0; t < count; t++) {
+            const simd::vfloat pt = simd::set1(p[t]);
+            const T *row = v[t] + d;
+            for (size_t j = 0; j < V_TILE; j++) {
+                a[j] = simd::fmadd(pt, simd::load(row + j * simd::width), a[j]);
+            }
+        }
+        for (size_t j = 0; j < V_TILE; j++) {
+            simd::store(acc + d + j * simd::width, a[j]);
+        }
+    }
+    for (; d + simd::width <= dv; d += simd::width) {
+        simd::vfloat a = simd::mul(simd::load(acc + d), c);
+        for (size_t t = 0; t < count; t++) {
+            a = simd::fmadd(simd::set1(p[t]), simd::load(v[t] + d), a);
+        }
+        simd::store(acc + d, a);
+    }
+    for (; d < dv; d++) {
+        float a = acc[d] * corr;
+        for (size_t t = 0; t < count; t++) {
+            a += p[t] * llaisys::utils::cast<float>(v[t][d]);
+        }
+        acc[d] = a;
+    }
+}
+
+// The K/V rows of one kv head: key t is at k + row(t) * ldk. Contiguous K/V use row(t) = t;
+// a paged cache maps t through the block table, blocks holding block_size consecutive rows.
+// INT8 rows carry one F32 scale each, at k_scale[row(t) * lds].
+template <typename C>
+struct KVRows {
+    const C *k;
+    const C *v;
+    size_t ldk;
+    size_t ldv;
+    const int32_t *block_table;
+    size_t block_size;
+    const float *k_scale;
+    const float *v_scale;
+    size_t lds;
+
+    size_t row(size_t t) const {
+        return block_table ? static_cast<size_t>(block_table[t / block_size]) * block_size + t % block_size : t;
+    }
+};
+
+// Runs the online softmax of `rows` query rows of one kv head over keys [k_begin, k_end).
+// Rows come in runs of `heads` query heads per position; row r sits at position
+// first_pos + r / heads and only sees keys up to it. On return acc holds the unnormalized
+// output, m the running max and l the sum of exp(score - m); rows that saw no key keep
+// m = -inf, l = 0, acc = 0.
+// INT8 K/V are dequantized on the fly: the key scale multiplies the dot product and the value
+// scale folds into the softmax weight of its row, so the inner loops only widen the bytes.
+template <typename C>
+void attend(float *acc, float *m, float *l, float *p, const float *qf, const KVRows<C> &kv, size_t rows,
+            size_t heads, size_t first_pos, size_t k_begin, size_t k_end, size_t head_dim, size_t v_head_dim) {
+    constexpr bool quantized = std::is_same_v<C, int8_t>;
+    const C *k_rows[KV_BLOCK];
+    const C *v_rows[KV_BLOCK];
+    float k_scales[quantized ? KV_BLOCK : 1];
+    float v_scales[quantized ? KV_BLOCK : 1];
+    float w[quantized ? KV_BLOCK : 1];
+    for (size_t r = 0; r < rows; r++) {
+        std::fill(acc + r * v_head_dim, acc + (r + 1) * v_head_dim, 0.0f);
+        m[r] = -std::numeric_limits<float>::infinity();
+        l[r] = 0.0f;
+    }
+    k_end = std::min(k_end, first_pos + (rows - 1) / heads + 1);
+    for (size_t t0 = k_begin; t0 < k_end; t0 += KV_BLOCK) {
+        // Resolve the tile's rows once for all query rows.
+        const size_t tile = std::min(KV_BLOCK, k_end - t0);
+        for (size_t t = 0; t < tile; t++) {
+            const size_t row = kv.row(t0 + t);
+            k_rows[t] = kv.k + row * kv.ldk;
+            v_rows[t] = kv.v + row * kv.ldv;
+            if constexpr (quantized) {
+                k_scales[t] = kv.k_scale[row * kv.lds];
+                v_scales[t] = kv.v_scale[row * kv.lds];
+            }
+        }
+        for (size_t r = 0; r < rows; r++) {
+            // Causal mask: row r sees keys up to first_pos + r / heads.
+            const size_t t1 = std::min({t0 + KV_BLOCK, k_end, first_pos + r / heads + 1});
+            if (t1 <= t0) {
+                continue;
+            }
+            const size_t count = t1 - t0;
+            float block_max = -std::numeric_limits<float>::infinity();
+            for (size_t t = 0; t < count; t++) {
+                p[t] = dot(qf + r * head_dim, k_rows[t], head_dim);
+                if constexpr (quantized) {
+                    p[t] *= k_scales[t];
+                }
+                block_max = std::max(block_max, p[t]);
+            }
+            // Rescale what was accumulated under the old max; exp(-inf) = 0 on the first tile.
+            const float m_new = std::max(m[r], block_max);
+            const float corr = std::exp(m[r] - m_new);
+            // p holds a whole tile, so the exponentials run over full vectors; lanes past count
+            // only see stale scores and are never read.
+            const simd::vfloat shift = simd::set1(m_new);
+            for (size_t t = 0; t < count; t += simd::width) {
+                simd::store(p + t, simd::exp(simd::sub(simd::load(p + t), shift)));
+            }
+            float sum = 0.0f;
+            for (size_t t = 0; t < count; t++) {
+                sum += p[t];
+            }
+            l[r] = l[r] * corr + sum;
+            m[r] = m_new;
+            if constexpr (quantized) {
+                for (size_t t = 0; t < count; t++) {
+                    w[t] = p[t] * v_scales[t];
+                }
+                accumulate(acc + r * v_head_dim, corr, w, v_rows, count, v_head_dim);
+            } else {
+                accumulate(acc + r * v_head_dim, corr, p, v_rows, count, v_head_dim);
+            }
+        }
+    }
+}
+
+// Number of slices the key range is cut into. Prefill has plenty of (query block, kv head)
+// tasks; decode with a long cache has only n_kv_head, so the keys are split until there are
+// enough tasks for a many-core pool. Depends on the shapes only, so the result does not
+// depend on the thread count.
+size_t kv_splits(size_t tasks, size_t total_len) {
+    if (tasks >= TARGET_TASKS) {
+        return 1;
+    }
+    size_t splits = std::min((TARGET_TASKS + tasks - 1) / tasks, total_len / MIN_SPLIT_LEN);
+    return std::max<size_t>(splits, 1);
+}
+
+// T is the type of q and the output, C the storage type of K/V.
+template <typename T, typename C>
+void self_attention_(T *out, const T *q, const C *k, const C *v, float scale, size_t seq_len, size_t total_len,
+                     size_t n_head, size_t n_kv_head, size_t head_dim, size_t v_head_dim,
+                     const int32_t *block_table, size_t block_size, const float *k_scale, const float *v_scale) {
+    const size_t group_size = n_head / n_kv_head;
+    const size_t past_len = total_len - seq_len;
+    const size_t ldk = n_kv_head * head_dim;
+    const size_t ldv = n_kv_head * v_head_dim;
+    // A block is q_per_block queries times the group_size heads sharing one kv head; query
+    // rows of a position are adjacent in q and attn_val.
+    const size_t q_per_block = std::max<size_t>(1, ROW_BLOCK / group_size);
+    const size_t max_rows = q_per_block * group_size;
+    const size_t q_blocks = (seq_len + q_per_block - 1) / q_per_block;
+    const size_t splits = kv_splits(q_blocks * n_kv_head, total_len);
+    // Split boundaries stay tile-aligned.
+    const size_t split_len = ((total_len + splits - 1) / splits + KV_BLOCK - 1) / KV_BLOCK * KV_BLOCK;
+
+    // With several splits every (split, query, head) leaves its partial (m, l, acc) here,
+    // merged below: partials[s][i][h] = {m, l, acc[v_head_dim]}.
+    const size_t partial_size = v_head_dim + 2;
+    std::vector<float> partials(splits > 1 ? splits * seq_len * n_head * partial_size : 0);
+
+    llaisys::core::parallel_for(splits * q_blocks * n_kv_head, 1, [&](size_t begin, size_t end) {
+        thread_local std::vector<float> scratch;
+        scratch.resize(max_rows * (head_dim + v_head_dim + 2) + KV_BLOCK);
+        float *qf = scratch.data();                // [max_rows, head_dim], pre-scaled queries
+        float *acc = qf + max_rows * head_dim;     // [max_rows, v_head_dim], unnormalized output
+        float *m = acc + max_rows * v_head_dim;    // [max_rows], running max
+        float *l = m + max_rows;                   // [max_rows], running sum of exp(score - m)
+        float *p = l + max_rows;                   // [KV_BLOCK], scores then probabilities
+
+        for (size_t task = begin; task < end; task++) {
+            const size_t kv_h = task % n_kv_head;
+            const size_t qb = task / n_kv_head % q_blocks;
+            const size_t split = task / n_kv_head / q_blocks;
+            const size_t i0 = qb * q_per_block;
+            const size_t rows = std::min(q_per_block, seq_len - i0) * group_size;
+            // Row r is query i0 + r / group_size, head kv_h * group_size + r % group_size.
+            auto row_index = [&](size_t r) {
+                return (i0 + r / group_size) * n_head + kv_h * group_size + r % group_size;
+            };
+
+            for (size_t r = 0; r < rows; r++) {
+                const T *q_row = q + row_index(r) * head_dim;
+                for (size_t d = 0; d < head_dim; d++) {
+                    qf[r * head_dim + d] = llaisys::utils::cast<float>(q_row[d]) * scale;
+                }
+            }
+            const KVRows<C> kv{k + kv_h * head_dim, v + kv_h * v_head_dim, ldk, ldv, block_table, block_size,
+                               k_scale ? k_scale + kv_h : nullptr, v_scale ? v_scale + kv_h : nullptr, n_kv_head};
+            attend(acc, m, l, p, qf, kv, rows, group_size, past_len + i0, split * split_len,
+                   (split + 1) * split_len, head_dim, v_head_dim);
+
+            for (size_t r = 0; r < rows; r++) {
+                const size_t row = row_index(r);
+                if (splits == 1) {
+                    T *out_row = out + row * v_head_dim;
+                    const float inv = 1.0f / l[r];
+                    for (size_t d = 0; d < v_head_dim; d++) {
+                        out_row[d] = llaisys::utils::cast<T>(acc[r * v_head_dim + d] * inv);
+                    }
+                } else {
+                    float *partial = partials.data() + (split * seq_len * n_head + row) * partial_size;
+                    partial[0] = m[r];
+                    partial[1] = l[r];
+                    std::copy(acc + r * v_head_dim, acc + (r + 1) * v_head_dim, partial + 2);
+                }
+            }
+        }
+    });
+    if (splits == 1) {
+        return;
+    }
+
+    // Log-sum-exp merge: out = sum_s exp(m_s - M) * acc_s / sum_s exp(m_s - M) * l_s, M = max_s m_s.
+    // Split 0 always holds key 0, so M is finite; empty splits get weight exp(-inf) = 0.
+    llaisys::core::parallel_for(seq_len * n_head, 1, [&](size_t begin, size_t end) {
+        thread_local std::vector<float> merged;
+        merged.resize(v_head_dim);
+        for (size_t row = begin; row < end; row++) {
+            float m_max = -std::numeric_limits<float>::infinity();
+            for (size_t s = 0; s < splits; s++) {
+                m_max = std::max(m_max, partials[(s * seq_len * n_head + row) * partial_size]);
+            }
+            std::fill(merged.begin(), merged.end(), 0.0f);
+            float l_sum = 0.0f;
+            for (size_t s = 0; s < splits; s++) {
+                const float *partial = partials.data() + (s * seq_len * n_head + row) * partial_size;
+                const float w = std::exp(partial[0] - m_max);
+                l_sum += w * partial[1];
+                for (size_t d = 0; d < v_head_dim; d++) {
+                    merged[d] += w * partial[2 + d];
+                }
+            }
+            T *out_row = out + row * v_head_dim;
+            const float inv = 1.0f / l_sum;
+            for (size_t d = 0; d < v_head_dim; d++) {
+                out_row[d] = llaisys::utils::cast<T>(merged[d] * inv);
+            }
+        }
+    });
+}
+
+template <typename T, typename... Args>
+void self_attention_kv(T *out, const T *q, const std::byte *k, const std::byte *v, llaisysDataType_t kv_type,
+                       Args... args) {
+    switch (kv_type) {
+    case LLAISYS_DTYPE_F32:
+        return self_attention_(out, q, reinterpret_cast<const float *>(k), reinterpret_cast<const float *>(v), args...);
+    case LLAISYS_DTYPE_BF16:
+        return self_attention_(out, q, reinterpret_cast<const llaisys::bf16_t *>(k),
+                               reinterpret_cast<const llaisys::bf16_t *>(v), args...);
+    case LLAISYS_DTYPE_F16:
+        return self_attention_(out, q, reinterpret_cast<const llaisys::fp16_t *>(k),
+                               reinterpret_cast<const llaisys::fp16_t *>(v), args...);
+    case LLAISYS_DTYPE_I8:
+        return self_attention_(out, q, reinterpret_cast<const int8_t *>(k), reinterpret_cast<const int8_t *>(v),
+                               args...);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(kv_type);
+    }
+}
+} // namespace
+
+namespace llaisys::ops::cpu {
+void self_attention(std::byte *attn_val, const std::byte *q, const std::byte *k, const std::byte *v,
+                    llaisysDataType_t type, llaisysDataType_t kv_type, float scale, size_t seq_len, size_t total_len,
+                    size_t n_head, size_t n_kv_head, size_t head_dim, size_t v_head_dim, const int32_t *block_table,
+                    size_t block_size, const float *k_scale, const float *v_scale) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return self_attention_kv(reinterpret_cast<float *>(attn_val), reinterpret_cast<const float *>(q), k, v,
+                                 kv_type, scale, seq_len, total_len, n_head, n_kv_head, head_dim, v_head_dim,
+                                 block_table, block_size, k_scale, v_scale);
+    case LLAISYS_DTYPE_BF16:
+        return self_attention_kv(reinterpret_cast<bf16_t *>(attn_val), reinterpret_cast<const bf16_t *>(q), k, v,
+                                 kv_type, scale, seq_len, total_len, n_head, n_kv_head, head_dim, v_head_dim,
+                                 block_table, block_size, k_scale, v_scale);
+    case LLAISYS_DTYPE_F16:
+        return self_attention_kv(reinterpret_cast<fp16_t *>(attn_val), reinterpret_cast<const fp16_t *>(q), k, v,
+                                 kv_type, scale, seq_len, total_len, n_head, n_kv_head, head_dim, v_head_dim,
+                                 block_table, block_size, k_scale, v_scale);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+} // namespace llaisys::ops::cpu
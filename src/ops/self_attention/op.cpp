@@ -7,6 +7,7 @@ namespace llaisys::ops {
 void self_attention(tensor_t attn_val, tensor_t q, tensor_t k, tensor_t v, float scale) {
     CHECK_SAME_DEVICE(attn_val, q, k);
     CHECK_SAME_DEVICE(q, v);
+    CHECK_SAME_DTYPE(attn_val->dtype(), q->dtype(), k->dtype(), v->dtype());
 
     // Shapes:
     // q: [seqlen, nhead, d]
@@ -23,24 +24,20 @@ void self_attention(tensor_t attn_val, tensor_t q, tensor_t k, tensor_t v, float
     
     size_t v_head_dim = v->shape()[2];
 
+    ASSERT(k->shape()[2] == head_dim, "SelfAttention: q and k must share the head dim");
+    ASSERT(v->shape()[0] == total_len && v->shape()[1] == n_kv_head, "SelfAttention: k and v must match");
+    ASSERT(n_head % n_kv_head == 0, "SelfAttention: nhead must be a multiple of nkvhead");
+    ASSERT(total_len >= seq_len, "SelfAttention: kv must cover every query position");
+    ASSERT(attn_val->isContiguous() && q->isContiguous() && k->isContiguous() && v->isContiguous(),
+           "SelfAttention: all tensors must be contiguous");
+
     llaisys::core::context().setDevice(attn_val->deviceType(), attn_val->deviceId());
 
     if (attn_val->deviceType() == LLAISYS_DEVICE_CPU) {
-        switch (attn_val->dtype()) {
-        case LLAISYS_DTYPE_F32:
-            return cpu::self_attention<float>(attn_val->data(), q->data(), k->data(), v->data(), scale, 
-                                              seq_len, total_len, n_head, n_kv_head, head_dim, v_head_dim);
-        case LLAISYS_DTYPE_F16:
-            return cpu::self_attention<fp16_t>(attn_val->data(), q->data(), k->data(), v->data(), scale, 
-                                              seq_len, total_len, n_head, n_kv_head, head_dim, v_head_dim);
-        case LLAISYS_DTYPE_BF16:
-            return cpu::self_attention<bf16_t>(attn_val->data(), q->data(), k->data(), v->data(), scale, 
-                                              seq_len, total_len, n_head, n_kv_head, head_dim, v_head_dim);
-        default:
-            EXCEPTION_UNSUPPORTED_DATATYPE(attn_val->dtype());
-        }
+        return cpu::self_attention(attn_val->data(), q->data(), k->data(), v->data(), attn_val->dtype(), k->dtype(),
+                                   scale, seq_len, total_len, n_head, n_kv_head, head_dim, v_head_dim);
     } else {
         EXCEPTION_UNSUPPORTED_DEVICE;
     }
 }
-} // namespace llaisys::ops
\ No newline at end of file
+} // namespace llaisys::ops
@@ -0,0 +1,63 @@
+#include "swiglu_cpu.hpp"
+
+#include "../../../core/thread_pool/thread_pool.hpp"
+#include "../../../utils.hpp"
+#include "../../../utils/simd_math.hpp"
+
+#include <type_traits>
+
+namespace {
+namespace simd = llaisys::utils::simd;
+
+template <typename T>
+void store(T *p, simd::vfloat v, size_t n) {
+    if constexpr (std::is_same_v<T, float>) {
+        if (n == simd::width) {
+            return simd::store(p, v);
+        }
+    }
+    float lanes[simd::width];
+    simd::store(lanes, v);
+    for (size_t k = 0; k < n; k++) {
+        p[k] = llaisys::utils::cast<T>(lanes[k]);
+    }
+}
+
+template <typename T>
+void swiglu_(T *out, const T *gate, const T *up, size_t numel) {
+    llaisys::core::parallel_for(numel, 4096, [&](size_t begin, size_t end) {
+        size_t i = begin;
+        for (; i + simd::width <= end; i += simd::width) {
+            simd::vfloat g = simd::load(gate + i);
+            store(out + i, simd::mul(simd::load(up + i), simd::silu(g)), simd::width);
+        }
+        // The tail goes through a zero-padded vector, so it rounds like the full ones.
+        if (i < end) {
+            float g[simd::width] = {}, u[simd::width] = {};
+            for (size_t k = 0; i + k < end; k++) {
+                g[k] = llaisys::utils::cast<float>(gate[i + k]);
+                u[k] = llaisys::utils::cast<float>(up[i + k]);
+            }
+            store(out + i, simd::mul(simd::load(u), simd::silu(simd::load(g))), end - i);
+        }
+    });
+}
+} // namespace
+
+namespace llaisys::ops::cpu {
+void swiglu(std::byte *out, const std::byte *gate, const std::byte *up, llaisysDataType_t type, size_t numel) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return swiglu_(reinterpret_cast<float *>(out), reinterpret_cast<const float *>(gate),
+                       reinterpret_cast<const float *>(up), numel);
+    case LLAISYS_DTYPE_BF16:
+        return swiglu_(reinterpret_cast<bf16_t *>(out), reinterpret_cast<const bf16_t *>(gate),
+                       reinterpret_cast<const bf16_t *>(up), numel);
+    case LLAISYS_DTYPE_F16:
+        return swiglu_(reinterpret_cast<fp16_t *>(out), reinterpret_cast<const fp16_t *>(gate),
+                       reinterpret_cast<const fp16_t *>(up), numel);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+} // namespace llaisys::ops::cpu
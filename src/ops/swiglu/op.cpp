@@ -13,16 +13,7 @@ void swiglu(tensor_t out, tensor_t gate, tensor_t up) {
     llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
 
     if (out->deviceType() == LLAISYS_DEVICE_CPU) {
-        switch (out->dtype()) {
-        case LLAISYS_DTYPE_F32:
-            return cpu::swiglu<float>(out->data(), gate->data(), up->data(), numel);
-        case LLAISYS_DTYPE_F16:
-            return cpu::swiglu<fp16_t>(out->data(), gate->data(), up->data(), numel);
-        case LLAISYS_DTYPE_BF16:
-            return cpu::swiglu<bf16_t>(out->data(), gate->data(), up->data(), numel);
-        default:
-            EXCEPTION_UNSUPPORTED_DATATYPE(out->dtype());
-        }
+        return cpu::swiglu(out->data(), gate->data(), up->data(), out->dtype(), numel);
     } else {
         EXCEPTION_UNSUPPORTED_DEVICE;
     }
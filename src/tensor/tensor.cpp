@@ -38,6 +38,21 @@ tensor_t Tensor::create(const std::vector<size_t> &shape,
     }
 }
 
+tensor_t Tensor::createPacked(const std::vector<size_t> &shape,
+                              llaisysDataType_t dtype,
+                              size_t panel_rows,
+                              llaisysDeviceType_t device_type,
+                              int device) {
+    CHECK_ARGUMENT(shape.size() == 2 && panel_rows > 0, "Packed tensors must be 2D with a positive panel size");
+    size_t padded_rows = (shape[0] + panel_rows - 1) / panel_rows * panel_rows;
+    // 分配补齐后的存储，元信息仍是逻辑形状
+    auto tensor = create({padded_rows, shape[1]}, dtype, device_type, device);
+    tensor->_meta.shape = shape;
+    tensor->_meta.layout = TensorLayout::PANEL_PACKED;
+    tensor->_meta.panel_rows = panel_rows;
+    return tensor;
+}
+
 std::byte *Tensor::data() {
     return _storage->memory() + _offset;
 }
@@ -78,6 +93,14 @@ size_t Tensor::elementSize() const {
     return utils::dsize(_meta.dtype);
 }
 
+TensorLayout Tensor::layout() const {
+    return _meta.layout;
+}
+
+size_t Tensor::panelRows() const {
+    return _meta.panel_rows;
+}
+
 std::string Tensor::info() const {
     std::stringstream ss;
 
@@ -91,6 +114,9 @@ std::string Tensor::info() const {
         ss << s << " ";
     }
     ss << "] dtype=" << this->dtype();
+    if (_meta.layout == TensorLayout::PANEL_PACKED) {
+        ss << " packed(panel_rows=" << _meta.panel_rows << ")";
+    }
 
     return ss.str();
 }
@@ -152,6 +178,9 @@ void Tensor::debug() const {
     core::context().setDevice(this->deviceType(), this->deviceId());
     core::context().runtime().api()->device_synchronize();
     std::cout << this->info() << std::endl;
+    if (_meta.layout != TensorLayout::STRIDED) {
+        return;
+    }
     if (this->deviceType() == LLAISYS_DEVICE_CPU) {
         debug_print(this->data(), this->shape(), this->strides(), this->dtype());
     } else {
@@ -167,6 +196,9 @@ void Tensor::debug() const {
 
 // Task-1.2: Check if tensor is contiguous
 bool Tensor::isContiguous() const {
+    if (_meta.layout != TensorLayout::STRIDED) {
+        return false;
+    }
     ptrdiff_t expected_stride = 1;
     size_t i = _meta.shape.size();
     while (i > 0) {
@@ -187,6 +219,9 @@ tensor_t Tensor::permute(const std::vector<size_t> &order) const {
     if (order.size() != _meta.shape.size()) {
         throw std::runtime_error("Permute order size does not match tensor dimensions.");
     }
+    if (_meta.layout != TensorLayout::STRIDED) {
+        throw std::runtime_error("Permute called on a packed tensor.");
+    }
 
     std::vector<size_t> new_shape;
     std::vector<ptrdiff_t> new_strides;
@@ -238,6 +273,9 @@ tensor_t Tensor::slice(size_t dim, size_t start, size_t end) const {
     if (start > end || end > _meta.shape[dim]) {
         throw std::runtime_error("Invalid slice indices.");
     }
+    if (_meta.layout != TensorLayout::STRIDED) {
+        throw std::runtime_error("Slice called on a packed tensor.");
+    }
 
     std::vector<size_t> new_shape = _meta.shape;
     new_shape[dim] = end - start;
@@ -252,6 +290,9 @@ tensor_t Tensor::slice(size_t dim, size_t start, size_t end) const {
 
 // Task-1.1: Load data from host
 void Tensor::load(const void *src_) {
+    if (_meta.layout != TensorLayout::STRIDED) {
+        throw std::runtime_error("Load called on a packed tensor; load the strided weight and pack it.");
+    }
     size_t total_bytes = this->numel() * this->elementSize();
     
     core::context().setDevice(this->deviceType(), this->deviceId());
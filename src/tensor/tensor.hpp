@@ -6,10 +6,20 @@ namespace llaisys {
 class Tensor;
 using tensor_t = std::shared_ptr<Tensor>;
 
+// 数据在内存中的排布
+enum class TensorLayout {
+    STRIDED, // 按 shape / strides 寻址
+    // 2D 权重 [N, K] 预打包为 panel 格式: 每 panel_rows 行为一组，组内按 [K][panel_rows] 存放，
+    // 末尾不足一组的行补零 (见 ops::linear_pack_weight)。只有认识该格式的算子能使用
+    PANEL_PACKED,
+};
+
 struct TensorMeta {
     llaisysDataType_t dtype;
     std::vector<size_t> shape;
     std::vector<ptrdiff_t> strides;
+    TensorLayout layout = TensorLayout::STRIDED;
+    size_t panel_rows = 0; // PANEL_PACKED: 每个 panel 的行数
 };
 
 class Tensor {
@@ -25,6 +35,13 @@ public:
         llaisysDataType_t dtype,
         llaisysDeviceType_t device_type = LLAISYS_DEVICE_CPU,
         int device = 0);
+    // 逻辑形状为 [N, K]，存储按 panel_rows 行分组打包 (TensorLayout::PANEL_PACKED)
+    static tensor_t createPacked(
+        const std::vector<size_t> &shape,
+        llaisysDataType_t dtype,
+        size_t panel_rows,
+        llaisysDeviceType_t device_type = LLAISYS_DEVICE_CPU,
+        int device = 0);
     ~Tensor() = default;
     // Info
     std::byte *data();
@@ -37,10 +54,13 @@ public:
     int deviceId() const;
     size_t numel() const;
     size_t elementSize() const;
+    TensorLayout layout() const;
+    size_t panelRows() const;
 
     std::string info() const;
     void debug() const;
 
+    // 打包张量不按 strides 寻址，总是返回 false
     bool isContiguous() const;
 
     // Meta Transform
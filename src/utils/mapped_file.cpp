@@ -0,0 +1,85 @@
+#include "mapped_file.hpp"
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace llaisys::utils {
+#if defined(_WIN32)
+MappedFile::MappedFile(const std::string &path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("MappedFile: cannot open " + path);
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw std::runtime_error("MappedFile: cannot stat " + path);
+    }
+    _file = file;
+    _size = static_cast<size_t>(size.QuadPart);
+    if (_size == 0) {
+        return;
+    }
+    _mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void *view = _mapping ? MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (_mapping) {
+            CloseHandle(_mapping);
+        }
+        CloseHandle(file);
+        throw std::runtime_error("MappedFile: cannot map " + path);
+    }
+    _data = static_cast<const std::byte *>(view);
+}
+
+MappedFile::~MappedFile() {
+    if (_data) {
+        UnmapViewOfFile(_data);
+    }
+    if (_mapping) {
+        CloseHandle(_mapping);
+    }
+    if (_file) {
+        CloseHandle(_file);
+    }
+}
+#else
+MappedFile::MappedFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("MappedFile: cannot open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("MappedFile: cannot stat " + path);
+    }
+    _size = static_cast<size_t>(st.st_size);
+    if (_size > 0) {
+        void *view = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("MappedFile: cannot map " + path);
+        }
+        _data = static_cast<const std::byte *>(view);
+    }
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (_data) {
+        munmap(const_cast<std::byte *>(_data), _size);
+    }
+}
+#endif
+} // namespace llaisys::utils
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace llaisys::utils {
+// Read-only memory map of a whole file; pages are read in by the OS on first touch.
+class MappedFile {
+public:
+    // Throws std::runtime_error if the file cannot be opened or mapped.
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const std::byte *data() const { return _data; }
+    size_t size() const { return _size; }
+
+private:
+    const std::byte *_data = nullptr;
+    size_t _size = 0;
+#if defined(_WIN32)
+    void *_file = nullptr;
+    void *_mapping = nullptr;
+#endif
+};
+} // namespace llaisys::utils
@@ -0,0 +1,234 @@
+#pragma once
+#include "types.hpp"
+
+#include <cmath>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+// The intrinsic headers use `__C` as a parameter name, which llaisys.h defines as a macro.
+#pragma push_macro("__C")
+#undef __C
+#include <immintrin.h>
+#pragma pop_macro("__C")
+#endif
+
+// Thin wrapper over the widest float vector the translation unit is compiled for.
+// Only cpu kernels (built with the `cpu-avx2` / `cpu-avx512` xmake options) should
+// include this header, so every user sees the same definitions.
+namespace llaisys::utils::simd {
+
+// 4-bit weights are stored in blocks of 32 values packed into 16 bytes: byte i holds
+// value i in its low nibble and value i + 16 in its high nibble.
+constexpr size_t q4_block = 32;
+
+#if defined(__AVX512F__)
+
+#define LLAISYS_SIMD_AVX512 1
+using vfloat = __m512;
+constexpr size_t width = 16;
+
+inline vfloat zero() { return _mm512_setzero_ps(); }
+inline vfloat set1(float x) { return _mm512_set1_ps(x); }
+inline vfloat load(const float *p) { return _mm512_loadu_ps(p); }
+inline vfloat load(const bf16_t *p) {
+    __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(h), 16));
+}
+inline vfloat load(const fp16_t *p) {
+    return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+}
+inline vfloat load(const int8_t *p) {
+    return _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))));
+}
+// Unpacks one q4 block into q4_block / width vectors of unsigned values 0..15.
+inline void load_q4(const uint8_t *p, vfloat *v) {
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i mask = _mm_set1_epi8(0x0F);
+    v[0] = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_and_si128(b, mask)));
+    v[1] = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_and_si128(_mm_srli_epi16(b, 4), mask)));
+}
+inline void store(float *p, vfloat v) { _mm512_storeu_ps(p, v); }
+inline vfloat add(vfloat a, vfloat b) { return _mm512_add_ps(a, b); }
+inline vfloat sub(vfloat a, vfloat b) { return _mm512_sub_ps(a, b); }
+inline vfloat mul(vfloat a, vfloat b) { return _mm512_mul_ps(a, b); }
+inline vfloat div(vfloat a, vfloat b) { return _mm512_div_ps(a, b); }
+inline vfloat max(vfloat a, vfloat b) { return _mm512_max_ps(a, b); }
+inline vfloat min(vfloat a, vfloat b) { return _mm512_min_ps(a, b); }
+inline vfloat fmadd(vfloat a, vfloat b, vfloat c) { return _mm512_fmadd_ps(a, b, c); }
+inline vfloat round(vfloat a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline vfloat floor(vfloat a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+// 2^n for integral n in [-127, 128]; n = -127 gives 0 and n = 128 gives inf.
+inline vfloat pow2(vfloat n) {
+    __m512i e = _mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(e, 23));
+}
+inline float reduce_add(vfloat v) { return _mm512_reduce_add_ps(v); }
+inline float reduce_max(vfloat v) { return _mm512_reduce_max_ps(v); }
+
+#elif defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+
+#define LLAISYS_SIMD_AVX2 1
+using vfloat = __m256;
+constexpr size_t width = 8;
+
+inline vfloat zero() { return _mm256_setzero_ps(); }
+inline vfloat set1(float x) { return _mm256_set1_ps(x); }
+inline vfloat load(const float *p) { return _mm256_loadu_ps(p); }
+inline vfloat load(const bf16_t *p) {
+    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+}
+inline vfloat load(const fp16_t *p) {
+    return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+inline vfloat load(const int8_t *p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))));
+}
+// Unpacks one q4 block into q4_block / width vectors of unsigned values 0..15.
+inline void load_q4(const uint8_t *p, vfloat *v) {
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i mask = _mm_set1_epi8(0x0F);
+    __m128i lo = _mm_and_si128(b, mask);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(b, 4), mask);
+    v[0] = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(lo));
+    v[1] = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)));
+    v[2] = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(hi));
+    v[3] = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)));
+}
+inline void store(float *p, vfloat v) { _mm256_storeu_ps(p, v); }
+inline vfloat add(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+inline vfloat sub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+inline vfloat mul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+inline vfloat div(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+inline vfloat max(vfloat a, vfloat b) { return _mm256_max_ps(a, b); }
+inline vfloat min(vfloat a, vfloat b) { return _mm256_min_ps(a, b); }
+inline vfloat fmadd(vfloat a, vfloat b, vfloat c) { return _mm256_fmadd_ps(a, b, c); }
+inline vfloat round(vfloat a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline vfloat floor(vfloat a) { return _mm256_floor_ps(a); }
+// 2^n for integral n in [-127, 128]; n = -127 gives 0 and n = 128 gives inf.
+inline vfloat pow2(vfloat n) {
+    __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+}
+inline float reduce_add(vfloat v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_movehdup_ps(s));
+    return _mm_cvtss_f32(s);
+}
+inline float reduce_max(vfloat v) {
+    __m128 s = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_max_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_max_ss(s, _mm_movehdup_ps(s));
+    return _mm_cvtss_f32(s);
+}
+
+#else
+
+// Portable fallback, small enough for the compiler to auto-vectorize.
+constexpr size_t width = 4;
+struct vfloat {
+    float v[width];
+};
+
+inline vfloat zero() { return vfloat{}; }
+inline vfloat set1(float x) { return vfloat{{x, x, x, x}}; }
+template <typename T>
+inline vfloat load(const T *p) {
+    vfloat r;
+    for (size_t i = 0; i < width; i++) {
+        r.v[i] = cast<float>(p[i]);
+    }
+    return r;
+}
+// Unpacks one q4 block into q4_block / width vectors of unsigned values 0..15.
+inline void load_q4(const uint8_t *p, vfloat *v) {
+    for (size_t i = 0; i < q4_block / 2; i++) {
+        v[i / width].v[i % width] = static_cast<float>(p[i] & 0x0F);
+        v[(i + q4_block / 2) / width].v[i % width] = static_cast<float>(p[i] >> 4);
+    }
+}
+inline void store(float *p, vfloat v) {
+    for (size_t i = 0; i < width; i++) {
+        p[i] = v.v[i];
+    }
+}
+inline vfloat add(vfloat a, vfloat b) {
+    for (size_t i = 0; i < width; i++) {
+        a.v[i] += b.v[i];
+    }
+    return a;
+}
+inline vfloat sub(vfloat a, vfloat b) {
+    for (size_t i = 0; i < width; i++) {
+        a.v[i] -= b.v[i];
+    }
+    return a;
+}
+inline vfloat mul(vfloat a, vfloat b) {
+    for (size_t i = 0; i < width; i++) {
+        a.v[i] *= b.v[i];
+    }
+    return a;
+}
+inline vfloat div(vfloat a, vfloat b) {
+    for (size_t i = 0; i < width; i++) {
+        a.v[i] /= b.v[i];
+    }
+    return a;
+}
+// max / min return b when either operand is NaN, like the x86 instructions.
+inline vfloat max(vfloat a, vfloat b) {
+    for (size_t i = 0; i < width; i++) {
+        a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+    }
+    return a;
+}
+inline vfloat min(vfloat a, vfloat b) {
+    for (size_t i = 0; i < width; i++) {
+        a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+    }
+    return a;
+}
+inline vfloat fmadd(vfloat a, vfloat b, vfloat c) {
+    for (size_t i = 0; i < width; i++) {
+        c.v[i] += a.v[i] * b.v[i];
+    }
+    return c;
+}
+inline vfloat round(vfloat a) {
+    for (size_t i = 0; i < width; i++) {
+        a.v[i] = std::nearbyint(a.v[i]);
+    }
+    return a;
+}
+inline vfloat floor(vfloat a) {
+    for (size_t i = 0; i < width; i++) {
+        a.v[i] = std::floor(a.v[i]);
+    }
+    return a;
+}
+// 2^n for integral n in [-127, 128]; n = -127 gives 0 and n = 128 gives inf.
+inline vfloat pow2(vfloat n) {
+    for (size_t i = 0; i < width; i++) {
+        n.v[i] = n.v[i] > -127.0f ? std::ldexp(1.0f, static_cast<int>(n.v[i])) : 0.0f;
+    }
+    return n;
+}
+inline float reduce_add(vfloat v) { return (v.v[0] + v.v[1]) + (v.v[2] + v.v[3]); }
+inline float reduce_max(vfloat v) {
+    float a = v.v[0] > v.v[1] ? v.v[0] : v.v[1];
+    float b = v.v[2] > v.v[3] ? v.v[2] : v.v[3];
+    return a > b ? a : b;
+}
+
+#endif
+
+inline void prefetch(const void *p) {
+#if defined(__AVX512F__) || defined(__AVX2__)
+    _mm_prefetch(reinterpret_cast<const char *>(p), _MM_HINT_T0);
+#else
+    (void)p;
+#endif
+}
+
+} // namespace llaisys::utils::simd
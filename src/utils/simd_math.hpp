@@ -0,0 +1,75 @@
+#pragma once
+#include "simd.hpp"
+
+// Vectorized exp, sigmoid and SiLU on simd::vfloat, for the cpu kernels (include it only from
+// them, like simd.hpp). Every lane is computed independently, so a kernel that pads its tail
+// into a full vector gets the same bits for an element wherever it sits.
+//
+// Two accuracy tiers for exp and the functions built on it, chosen at compile time: defining
+// LLAISYS_FAST_MATH (the `cpu-fast-math` xmake option) drops one polynomial term and the
+// gradual underflow. Maximum errors, measured against double over every float of the range,
+// identical for AVX2 and AVX-512 (the non-FMA fallback is looser):
+//
+//                                     default              LLAISYS_FAST_MATH
+//   exp      x in [-87.3, 88.7]       1.1 ulp              2.3 ulp (x <= 88.3)
+//   sigmoid  x >= -87.3               2.5 ulp              3.4 ulp
+//   silu     x >= -88.7               2.4 ulp              3.5 ulp (x >= -88.3)
+//
+// exp returns +inf past ln(FLT_MAX) (past 88.37 in the fast tier) and 0 below the subnormals
+// (below 2^-126 in the fast tier); NaN propagates. sigmoid and silu go to 0 where e^-x
+// overflows, which for silu is off by at most 3e-37.
+namespace llaisys::utils::simd {
+
+namespace math_detail {
+constexpr float log2e = 1.44269504088896341f;
+// ln 2 split so that n * ln2_hi is exact for |n| < 2^9.
+constexpr float ln2_hi = 0.693359375f;
+constexpr float ln2_lo = -2.12194440e-4f;
+} // namespace math_detail
+
+// e^x = 2^n * e^r with n = round(x / ln2) and |r| <= ln2 / 2.
+inline vfloat exp(vfloat x) {
+    using namespace math_detail;
+#if defined(LLAISYS_FAST_MATH)
+    // n in [-127, 128]: 2^n is a single exponent field, n = -127 yields 0 and n = 128 inf.
+    x = max(set1(-88.0f), min(set1(89.0f), x));
+    vfloat n = round(mul(x, set1(log2e)));
+    vfloat r = fmadd(n, set1(-ln2_hi), x);
+    r = fmadd(n, set1(-ln2_lo), r);
+    // e^r = 1 + r + r^2 * p(r), p one degree shorter than the default tier's
+    vfloat p = fmadd(set1(8.312538e-3f), r, set1(4.1890122e-2f));
+    p = fmadd(p, r, set1(1.6667114e-1f));
+    p = fmadd(p, r, set1(4.999923e-1f));
+    p = fmadd(mul(p, r), r, r);
+    return mul(add(p, set1(1.0f)), pow2(n));
+#else
+    // Past the limits e^x is 0 or inf anyway; 2^n is applied in two halves so that the
+    // subnormal and overflowing results round like a single scaling would.
+    x = max(set1(-104.0f), min(set1(89.0f), x));
+    vfloat n = round(mul(x, set1(log2e)));
+    vfloat r = fmadd(n, set1(-ln2_hi), x);
+    r = fmadd(n, set1(-ln2_lo), r);
+    // Cephes expf polynomial
+    vfloat p = fmadd(set1(1.9875691500e-4f), r, set1(1.3981999507e-3f));
+    p = fmadd(p, r, set1(8.3334519073e-3f));
+    p = fmadd(p, r, set1(4.1665795894e-2f));
+    p = fmadd(p, r, set1(1.6666665459e-1f));
+    p = fmadd(p, r, set1(5.0000001201e-1f));
+    p = fmadd(mul(p, r), r, r);
+    vfloat half = floor(mul(n, set1(0.5f)));
+    return mul(mul(add(p, set1(1.0f)), pow2(half)), pow2(sub(n, half)));
+#endif
+}
+
+// 1 / (1 + e^-x)
+inline vfloat sigmoid(vfloat x) {
+    vfloat one = set1(1.0f);
+    return div(one, add(one, exp(sub(zero(), x))));
+}
+
+// x * sigmoid(x) = x / (1 + e^-x)
+inline vfloat silu(vfloat x) {
+    return div(x, add(set1(1.0f), exp(sub(zero(), x))));
+}
+
+} // namespace llaisys::utils::simd
@@ -1,3 +1,4 @@
+#pragma once
 #include "llaisys.h"
 
 #include <iostream>
@@ -0,0 +1,208 @@
+import sys
+import os
+
+parent_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+sys.path.insert(0, parent_dir)
+import llaisys
+import torch
+from test_utils import arrange_tensor, random_tensor, zero_tensor, check_equal, benchmark
+
+
+def from_torch(t, dtype_name, device_name):
+    _, t_ = zero_tensor(tuple(t.shape), dtype_name, device_name)
+    api = llaisys.RuntimeAPI(llaisys.DeviceType.CPU)
+    api.memcpy_sync(t_.data_ptr(), t.data_ptr(), t.numel() * t.element_size(), llaisys.MemcpyKind.D2D)
+    return t_
+
+
+def to_torch(t_, shape, dtype_name):
+    t, _ = zero_tensor(shape, dtype_name, "cpu")
+    api = llaisys.RuntimeAPI(llaisys.DeviceType.CPU)
+    api.memcpy_sync(t.data_ptr(), t_.data_ptr(), t.numel() * t.element_size(), llaisys.MemcpyKind.D2D)
+    return t
+
+
+def torch_kv_append(k_cache, v_cache, k_scale, v_scale, k, v, block_table, pos):
+    block_size = k_cache.shape[1]
+    for i in range(k.shape[0]):
+        t = pos + i
+        block, row = block_table[t // block_size].item(), t % block_size
+        for cache, scale, x in ((k_cache, k_scale, k[i]), (v_cache, v_scale, v[i])):
+            if scale is None:
+                cache[block, row] = x.to(cache.dtype)
+                continue
+            # symmetric per (token, kv head)
+            amax = x.float().abs().amax(dim=-1)
+            inv = torch.where(amax > 0, 127.0 / amax, torch.zeros_like(amax))
+            cache[block, row] = torch.round(x.float() * inv[:, None]).clamp(-127, 127).to(torch.int8)
+            scale[block, row] = amax / 127.0
+
+
+def test_op_kv_append(
+    n,
+    pos,
+    nkvh,
+    hd,
+    block_size,
+    dtype_name="f32",
+    cache_dtype_name="f32",
+    device_name="cpu",
+    profile=False,
+):
+    print(
+        f"   n={n} pos={pos} nkvh={nkvh} hd={hd} block_size={block_size} dtype <{dtype_name}> cache <{cache_dtype_name}>"
+    )
+    used_blocks = (pos + n + block_size - 1) // block_size
+    num_blocks = used_blocks + 2
+    cache_shape = (num_blocks, block_size, nkvh, hd)
+    k, k_ = random_tensor((n, nkvh, hd), dtype_name, device_name, scale=2.0, bias=-1.0)
+    v, v_ = random_tensor((n, nkvh, hd), dtype_name, device_name, scale=2.0, bias=-1.0)
+    k_cache, k_cache_ = zero_tensor(cache_shape, cache_dtype_name, device_name)
+    v_cache, v_cache_ = zero_tensor(cache_shape, cache_dtype_name, device_name)
+    k_scale = v_scale = k_scale_ = v_scale_ = None
+    if cache_dtype_name == "i8":
+        k_scale, k_scale_ = zero_tensor(cache_shape[:-1], "f32", device_name)
+        v_scale, v_scale_ = zero_tensor(cache_shape[:-1], "f32", device_name)
+    # every block of the sequence is a distinct block of the pool, in any order
+    block_table = torch.randperm(num_blocks, dtype=torch.int32)[:used_blocks].contiguous()
+    block_table_ = from_torch(block_table, "i32", device_name)
+
+    torch_kv_append(k_cache, v_cache, k_scale, v_scale, k, v, block_table, pos)
+    llaisys.Ops.kv_append(k_cache_, v_cache_, k_, v_, block_table_, pos, k_scale_, v_scale_)
+
+    if cache_dtype_name == "i8":
+        assert check_equal(k_scale_, k_scale, atol=1e-7, rtol=1e-6)
+        assert check_equal(v_scale_, v_scale, atol=1e-7, rtol=1e-6)
+        # Values exactly halfway between two steps may round either way.
+        assert check_equal(k_cache_, k_cache, atol=1, rtol=0)
+        assert check_equal(v_cache_, v_cache, atol=1, rtol=0)
+    elif cache_dtype_name == dtype_name:
+        assert check_equal(k_cache_, k_cache, strict=True)
+        assert check_equal(v_cache_, v_cache, strict=True)
+    else:
+        # narrowing may round differently from torch by one step
+        rtol = {"f32": 1e-6, "f16": 2e-3, "bf16": 1e-2}[cache_dtype_name]
+        assert check_equal(k_cache_, k_cache, atol=0, rtol=rtol)
+        assert check_equal(v_cache_, v_cache, atol=0, rtol=rtol)
+
+    if profile:
+        benchmark(
+            lambda: torch_kv_append(k_cache, v_cache, k_scale, v_scale, k, v, block_table, pos),
+            lambda: llaisys.Ops.kv_append(k_cache_, v_cache_, k_, v_, block_table_, pos, k_scale_, v_scale_),
+            device_name,
+        )
+
+
+def test_op_rope_kv_append(
+    n,
+    pos,
+    nh,
+    nkvh,
+    hd,
+    block_size,
+    dtype_name="f32",
+    cache_dtype_name="f32",
+    device_name="cpu",
+    profile=False,
+):
+    print(
+        f"   rope n={n} pos={pos} nh={nh} nkvh={nkvh} hd={hd} block_size={block_size} dtype <{dtype_name}> cache <{cache_dtype_name}>"
+    )
+    used_blocks = (pos + n + block_size - 1) // block_size
+    num_blocks = used_blocks + 2
+    cache_shape = (num_blocks, block_size, nkvh, hd)
+    theta = 10000.0
+    _, table_ = zero_tensor((pos + n + 3, 2, hd // 2), "f32", device_name)
+    llaisys.Ops.rope_table(table_, theta)
+    # q/k/v 取自融合 QKV 输出的按头切片，token 之间有间隔
+    _, qkv_ = random_tensor((n, nh + 2 * nkvh, hd), dtype_name, device_name, scale=2.0, bias=-1.0)
+    q_ = qkv_.slice(1, 0, nh)
+    k_ = qkv_.slice(1, nh, nh + nkvh)
+    v_ = qkv_.slice(1, nh + nkvh, nh + 2 * nkvh)
+    block_table = torch.randperm(num_blocks, dtype=torch.int32)[:used_blocks].contiguous()
+    block_table_ = from_torch(block_table, "i32", device_name)
+    _, pos_ids_ = arrange_tensor(pos, pos + n, device_name)
+
+    def make_caches():
+        k_cache_ = zero_tensor(cache_shape, cache_dtype_name, device_name)[1]
+        v_cache_ = zero_tensor(cache_shape, cache_dtype_name, device_name)[1]
+        if cache_dtype_name != "i8":
+            return k_cache_, v_cache_, None, None
+        k_scale_ = zero_tensor(cache_shape[:-1], "f32", device_name)[1]
+        v_scale_ = zero_tensor(cache_shape[:-1], "f32", device_name)[1]
+        return k_cache_, v_cache_, k_scale_, v_scale_
+
+    # 参照: 分开的 rope + rope + kv_append
+    ref = make_caches()
+    _, q_ref_ = zero_tensor((n, nh, hd), dtype_name, device_name)
+    _, k_rot_ = zero_tensor((n, nkvh, hd), dtype_name, device_name)
+
+    def separate():
+        llaisys.Ops.rope(q_ref_, q_, pos_ids_, theta, table=table_)
+        llaisys.Ops.rope(k_rot_, k_, pos_ids_, theta, table=table_)
+        llaisys.Ops.kv_append(ref[0], ref[1], k_rot_, v_, block_table_, pos, ref[2], ref[3])
+
+    fused = make_caches()
+    _, q_out_ = zero_tensor((n, nh, hd), dtype_name, device_name)
+
+    def fused_op():
+        llaisys.Ops.rope_kv_append(
+            q_out_, fused[0], fused[1], q_, k_, v_, table_, block_table_, pos, fused[2], fused[3]
+        )
+
+    separate()
+    fused_op()
+    assert check_equal(q_out_, to_torch(q_ref_, (n, nh, hd), dtype_name), strict=True)
+    for t_, ref_t_, t_dtype_name in zip(fused, ref, (cache_dtype_name, cache_dtype_name, "f32", "f32")):
+        if t_ is not None:
+            assert check_equal(t_, to_torch(ref_t_, t_.shape(), t_dtype_name), strict=True)
+
+    if profile:
+        benchmark(separate, fused_op, device_name)
+
+
+if __name__ == "__main__":
+    import argparse
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--device", default="cpu", choices=["cpu", "nvidia"], type=str)
+    parser.add_argument("--profile", action="store_true")
+    args = parser.parse_args()
+    testShapes = [
+        # n, pos, nkvh, hd, block_size
+        (1, 0, 1, 4, 16),
+        # decode step in the middle of a block
+        (1, 21, 2, 8, 16),
+        # prefill chunk crossing several blocks
+        (19, 5, 2, 32, 4),
+        (40, 64, 4, 16, 16),
+    ]
+    testDtypes = [
+        # k/v type, cache type
+        ("f32", "f32"),
+        ("f32", "f16"),
+        ("f32", "bf16"),
+        ("f32", "i8"),
+        ("bf16", "bf16"),
+        ("bf16", "f32"),
+        ("f16", "i8"),
+    ]
+    print(f"Testing Ops.kv_append on {args.device}")
+    for shape in testShapes:
+        for dtype_name, cache_dtype_name in testDtypes:
+            test_op_kv_append(*shape, dtype_name, cache_dtype_name, args.device, args.profile)
+
+    ropeShapes = [
+        # n, pos, nh, nkvh, hd, block_size
+        (1, 21, 4, 2, 8, 16),
+        (19, 5, 4, 2, 32, 4),
+        # Qwen2 1.5B: 12 q heads, 2 kv heads of 128
+        (1, 300, 12, 2, 128, 16),
+        (64, 64, 12, 2, 128, 16),
+    ]
+    print(f"Testing Ops.rope_kv_append on {args.device}")
+    for shape in ropeShapes:
+        for dtype_name, cache_dtype_name in testDtypes:
+            test_op_rope_kv_append(*shape, dtype_name, cache_dtype_name, args.device, args.profile)
+
+    print("\033[92mTest passed!\033[0m\n")
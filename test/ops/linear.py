@@ -22,27 +22,100 @@ def test_op_linear(
     rtol=1e-5,
     device_name="cpu",
     profile=False,
+    weight_dtype_name=None,
 ):
-    print(f"   out {out_shape}, x {x_shape}, w {w_shape}, bias {use_bias}, dtype <{dtype_name}>")
+    # weight/bias may use a different dtype from the activations (e.g. f32 x with bf16 w)
+    weight_dtype_name = weight_dtype_name or dtype_name
+    print(
+        f"   out {out_shape}, x {x_shape}, w {w_shape}, bias {use_bias}, dtype <{dtype_name}>, weight dtype <{weight_dtype_name}>"
+    )
     x, x_ = random_tensor(x_shape, dtype_name, device_name, scale=0.1)
-    w, w_ = random_tensor(w_shape, dtype_name, device_name, scale=0.01)
+    w, w_ = random_tensor(w_shape, weight_dtype_name, device_name, scale=0.01)
 
     bias, bias_ = None, None
     if use_bias:
-        bias, bias_ = random_tensor((w_shape[0],), dtype_name, device_name)
+        bias, bias_ = random_tensor((w_shape[0],), weight_dtype_name, device_name)
 
     out, out_ = random_tensor(out_shape, dtype_name, device_name)
-    torch_linear(out, x, w, bias)
+    torch_linear(
+        out,
+        x,
+        w.to(x.dtype),
+        bias.to(x.dtype) if bias is not None else None,
+    )
     llaisys.Ops.linear(out_, x_, w_, bias_)
 
     assert check_equal(out_, out, atol=atol, rtol=rtol)
 
     if profile:
-        benchmark(
-            lambda: torch_linear(out, x, w, bias),
+        torch_time, llaisys_time = benchmark(
+            lambda: torch_linear(out, x, w.to(x.dtype), bias.to(x.dtype) if bias is not None else None),
             lambda: llaisys.Ops.linear(out_, x_, w_, bias_),
             device_name,
         )
+        flops = 2 * x.numel() * w_shape[0]
+        print(
+            f"        Torch: {flops / torch_time / 1e9:.2f} GFLOP/s \n        LLAISYS: {flops / llaisys_time / 1e9:.2f} GFLOP/s"
+        )
+        # Decode is bound by streaming the weights, so report the effective bandwidth too
+        weight_bytes = w.numel() * w.element_size()
+        print(
+            f"        Torch: {weight_bytes / torch_time / 1e9:.2f} GB/s weights \n        LLAISYS: {weight_bytes / llaisys_time / 1e9:.2f} GB/s weights"
+        )
+
+
+def test_op_linear_epilogue(
+    m,
+    k,
+    n,
+    in_place,
+    alpha,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+):
+    # out = alpha * x @ w^T + bias + residual, with residual optionally being out itself
+    print(f"   epilogue x ({m}, {k}), w ({n}, {k}), alpha {alpha}, in place {in_place}, dtype <{dtype_name}>")
+    x, x_ = random_tensor((m, k), dtype_name, device_name, scale=0.1)
+    w, w_ = random_tensor((n, k), dtype_name, device_name, scale=0.01)
+    bias, bias_ = random_tensor((n,), dtype_name, device_name)
+    residual, residual_ = random_tensor((m, n), dtype_name, device_name)
+
+    expected = (alpha * torch.nn.functional.linear(x.float(), w.float()) + bias.float() + residual.float()).to(x.dtype)
+    if in_place:
+        out_ = residual_
+    else:
+        _, out_ = random_tensor((m, n), dtype_name, device_name)
+    llaisys.Ops.linear_epilogue(out_, x_, w_, bias_, residual_, alpha)
+
+    assert check_equal(out_, expected, atol=atol, rtol=rtol)
+
+
+def test_op_linear_packed(
+    m,
+    k,
+    n,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+    weight_dtype_name=None,
+):
+    # a weight prepacked once must give the same result as the row-major one
+    weight_dtype_name = weight_dtype_name or dtype_name
+    print(f"   packed x ({m}, {k}), w ({n}, {k}), dtype <{dtype_name}>, weight dtype <{weight_dtype_name}>")
+    x, x_ = random_tensor((m, k), dtype_name, device_name, scale=0.1)
+    w, w_ = random_tensor((n, k), weight_dtype_name, device_name, scale=0.01)
+    bias, bias_ = random_tensor((n,), dtype_name, device_name)
+    packed_ = llaisys.Ops.linear_pack_weight(w_)
+    assert packed_.shape() == (n, k)
+
+    out, out_ = random_tensor((m, n), dtype_name, device_name)
+    torch_linear(out, x, w.to(x.dtype), bias)
+    llaisys.Ops.linear(out_, x_, packed_, bias_)
+
+    assert check_equal(out_, out, atol=atol, rtol=rtol)
 
 
 if __name__ == "__main__":
@@ -56,6 +129,13 @@ if __name__ == "__main__":
         ((2, 3), (2, 4), (3, 4), True),
         ((512, 4096), (512, 4096), (4096, 4096), True),
     ]
+    if args.profile:
+        # Qwen2-1.5B decode and prefill projection shapes
+        testShapes += [
+            ((1, 1536), (1, 1536), (1536, 1536), True),
+            ((1, 8960), (1, 1536), (8960, 1536), False),
+            ((128, 8960), (128, 1536), (8960, 1536), False),
+        ]
     testDtypePrec = [
         # type, atol, rtol
         ("f32", 1e-5, 1e-5),
@@ -67,4 +147,23 @@ if __name__ == "__main__":
         for dtype_name, atol, rtol in testDtypePrec:
             test_op_linear(*shapes, dtype_name, atol, rtol, args.device, args.profile)
 
+    testMixedDtypePrec = [
+        # activation type, weight type, atol, rtol
+        ("f32", "bf16", 1e-4, 1e-4),
+        ("f32", "f16", 1e-4, 1e-4),
+    ]
+    for shapes in testShapes:
+        for dtype_name, weight_dtype_name, atol, rtol in testMixedDtypePrec:
+            test_op_linear(*shapes, dtype_name, atol, rtol, args.device, args.profile, weight_dtype_name)
+
+    # (M, K, N): decode (GEMV path) and prefill (GEMM path) with ragged edges
+    for m, k, n in [(1, 64, 40), (3, 100, 37), (130, 256, 200)]:
+        for in_place in [False, True]:
+            for dtype_name, atol, rtol in testDtypePrec:
+                test_op_linear_epilogue(m, k, n, in_place, 0.5, dtype_name, atol, rtol, args.device)
+        for dtype_name, atol, rtol in testDtypePrec:
+            test_op_linear_packed(m, k, n, dtype_name, atol, rtol, args.device)
+        for dtype_name, weight_dtype_name, atol, rtol in testMixedDtypePrec:
+            test_op_linear_packed(m, k, n, dtype_name, atol, rtol, args.device, weight_dtype_name)
+
     print("\033[92mTest passed!\033[0m\n")
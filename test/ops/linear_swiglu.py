@@ -0,0 +1,73 @@
+import sys
+import os
+
+parent_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+sys.path.insert(0, parent_dir)
+import llaisys
+import torch
+from test_utils import random_tensor, check_equal, benchmark
+
+
+def torch_linear_swiglu(out, x, w_gate, w_up):
+    gate = torch.nn.functional.linear(x, w_gate)
+    up = torch.nn.functional.linear(x, w_up)
+    torch.mul(up, gate / (1 + torch.exp(-gate.float()).to(out.dtype)), out=out)
+
+
+def test_op_linear_swiglu(
+    m,
+    k,
+    i,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+    profile=False,
+    weight_dtype_name=None,
+):
+    weight_dtype_name = weight_dtype_name or dtype_name
+    print(f"   x ({m}, {k}), intermediate {i}, dtype <{dtype_name}>, weight dtype <{weight_dtype_name}>")
+    x, x_ = random_tensor((m, k), dtype_name, device_name, scale=0.1)
+    # llaisys takes gate and up interleaved row by row
+    w, w_ = random_tensor((2 * i, k), weight_dtype_name, device_name, scale=0.1)
+    w_gate, w_up = w[0::2].to(x.dtype), w[1::2].to(x.dtype)
+
+    out, out_ = random_tensor((m, i), dtype_name, device_name)
+    torch_linear_swiglu(out, x, w_gate, w_up)
+    llaisys.Ops.linear_swiglu(out_, x_, w_)
+
+    assert check_equal(out_, out, atol=atol, rtol=rtol)
+
+    if profile:
+        benchmark(
+            lambda: torch_linear_swiglu(out, x, w_gate, w_up),
+            lambda: llaisys.Ops.linear_swiglu(out_, x_, w_),
+            device_name,
+        )
+
+
+if __name__ == "__main__":
+    import argparse
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--device", default="cpu", choices=["cpu", "nvidia"], type=str)
+    parser.add_argument("--profile", action="store_true")
+    args = parser.parse_args()
+    # (M, K, I): decode (GEMV path) and prefill (GEMM path), with ragged edges
+    testShapes = [(1, 64, 24), (3, 100, 37), (130, 256, 200)]
+    if args.profile:
+        # Qwen2-1.5B MLP
+        testShapes += [(1, 1536, 8960), (128, 1536, 8960)]
+    testDtypePrec = [
+        # activation type, weight type, atol, rtol
+        ("f32", "f32", 1e-5, 1e-5),
+        ("f16", "f16", 1e-3, 1e-3),
+        ("bf16", "bf16", 1e-2, 1e-2),
+        ("f32", "bf16", 1e-4, 1e-4),
+    ]
+    print(f"Testing Ops.linear_swiglu on {args.device}")
+    for shape in testShapes:
+        for dtype_name, weight_dtype_name, atol, rtol in testDtypePrec:
+            test_op_linear_swiglu(*shape, dtype_name, atol, rtol, args.device, args.profile, weight_dtype_name)
+
+    print("\033[92mTest passed!\033[0m\n")
@@ -0,0 +1,154 @@
+import sys
+import os
+
+parent_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+sys.path.insert(0, parent_dir)
+import llaisys
+import torch
+from test_utils import random_tensor, random_int_tensor, check_equal, benchmark, torch_dtype
+
+
+def torch_self_attention(attn_val, query, key, value, scale):
+    query = query.transpose(-2, -3)
+    key = key.transpose(-2, -3)
+    value = value.transpose(-2, -3)
+    L, S = query.size(-2), key.size(-2)
+    attn_bias = torch.zeros(L, S, dtype=query.dtype, device=query.device)
+
+    temp_mask = torch.ones(L, S, dtype=torch.bool).tril(diagonal=S-L)
+    attn_bias.masked_fill_(temp_mask.logical_not(), float("-inf"))
+    attn_bias.to(query.dtype)
+
+    key = key.repeat_interleave(query.size(-3) // key.size(-3), -3)
+    value = value.repeat_interleave(query.size(-3) // value.size(-3), -3)
+
+    attn_weight = query @ key.transpose(-2, -1) * scale
+    attn_weight += attn_bias
+    attn_weight = torch.softmax(attn_weight, dim=-1)
+    attn_val.copy_((attn_weight @ value).transpose(-2, -3))
+
+
+def torch_paged_attention(attn_val, query, k_cache, v_cache, block_table, total_len, scale):
+    # gather the sequence's blocks in table order, then attend as usual
+    nkvh, hd = k_cache.shape[-2:]
+    key = k_cache[block_table.long()].reshape(-1, nkvh, hd)[:total_len]
+    value = v_cache[block_table.long()].reshape(-1, nkvh, v_cache.shape[-1])[:total_len]
+    torch_self_attention(attn_val, query, key, value, scale)
+
+
+def test_op_paged_attention(
+    qlen,
+    kvlen,
+    nh,
+    nkvh,
+    hd,
+    block_size,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+    profile=False,
+):
+    print(
+        f"   qlen={qlen} kvlen={kvlen} nh={nh} nkvh={nkvh} hd={hd} block_size={block_size} dtype <{dtype_name}>"
+    )
+    used_blocks = (kvlen + block_size - 1) // block_size
+    num_blocks = 2 * used_blocks + 1
+    q, q_ = random_tensor((qlen, nh, hd), dtype_name, device_name)
+    k_cache, k_cache_ = random_tensor((num_blocks, block_size, nkvh, hd), dtype_name, device_name)
+    v_cache, v_cache_ = random_tensor((num_blocks, block_size, nkvh, hd), dtype_name, device_name)
+    # blocks of a sequence are scattered over the pool in any order
+    block_table, block_table_ = random_int_tensor((used_blocks,), device_name, "i32", high=num_blocks)
+    scale = 1.0 / (hd**0.5)
+
+    attn_val, attn_val_ = random_tensor((qlen, nh, hd), dtype_name, device_name)
+    torch_paged_attention(attn_val, q, k_cache, v_cache, block_table, kvlen, scale)
+    llaisys.Ops.paged_attention(attn_val_, q_, k_cache_, v_cache_, block_table_, kvlen, scale)
+    assert check_equal(attn_val_, attn_val, atol=atol, rtol=rtol)
+
+    if profile:
+        benchmark(
+            lambda: torch_paged_attention(attn_val, q, k_cache, v_cache, block_table, kvlen, scale),
+            lambda: llaisys.Ops.paged_attention(attn_val_, q_, k_cache_, v_cache_, block_table_, kvlen, scale),
+            device_name,
+        )
+
+
+def test_op_paged_attention_cache_dtype(
+    qlen,
+    kvlen,
+    nh,
+    nkvh,
+    hd,
+    block_size,
+    cache_dtype_name,
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+):
+    print(
+        f"   qlen={qlen} kvlen={kvlen} nh={nh} nkvh={nkvh} hd={hd} block_size={block_size} q <f32> cache <{cache_dtype_name}>"
+    )
+    used_blocks = (kvlen + block_size - 1) // block_size
+    num_blocks = used_blocks + 3
+    cache_shape = (num_blocks, block_size, nkvh, hd)
+    q, q_ = random_tensor((qlen, nh, hd), "f32", device_name)
+    k_scale = v_scale = k_scale_ = v_scale_ = None
+    if cache_dtype_name == "i8":
+        k_cache, k_cache_ = random_int_tensor(cache_shape, device_name, "i8", low=-127, high=128)
+        v_cache, v_cache_ = random_int_tensor(cache_shape, device_name, "i8", low=-127, high=128)
+        k_scale, k_scale_ = random_tensor(cache_shape[:-1], "f32", device_name, scale=0.02)
+        v_scale, v_scale_ = random_tensor(cache_shape[:-1], "f32", device_name, scale=0.02)
+        # the reference attends over the dequantized cache
+        k_ref = k_cache.float() * k_scale[..., None]
+        v_ref = v_cache.float() * v_scale[..., None]
+    else:
+        k_cache, k_cache_ = random_tensor(cache_shape, cache_dtype_name, device_name)
+        v_cache, v_cache_ = random_tensor(cache_shape, cache_dtype_name, device_name)
+        k_ref = k_cache.to(torch_dtype("f32"))
+        v_ref = v_cache.to(torch_dtype("f32"))
+    block_table, block_table_ = random_int_tensor((used_blocks,), device_name, "i32", high=num_blocks)
+    scale = 1.0 / (hd**0.5)
+
+    attn_val, attn_val_ = random_tensor((qlen, nh, hd), "f32", device_name)
+    torch_paged_attention(attn_val, q, k_ref, v_ref, block_table, kvlen, scale)
+    llaisys.Ops.paged_attention(
+        attn_val_, q_, k_cache_, v_cache_, block_table_, kvlen, scale, k_scale_, v_scale_
+    )
+    assert check_equal(attn_val_, attn_val, atol=atol, rtol=rtol)
+
+
+if __name__ == "__main__":
+    import argparse
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--device", default="cpu", choices=["cpu", "nvidia"], type=str)
+    parser.add_argument("--profile", action="store_true")
+    args = parser.parse_args()
+    testShapes = [
+        # qlen, kvlen, nh, nkvh, hd, block_size
+        (2, 2, 1, 1, 4, 16),
+        (5, 11, 4, 2, 8, 4),
+        # prefill chunk after cached tokens, partial last block
+        (19, 70, 8, 2, 32, 16),
+        # decode on a long cache, split over the keys
+        (1, 1000, 4, 2, 32, 16),
+    ]
+    testDtypePrec = [
+        # type, atol, rtol
+        ("f32", 1e-5, 1e-5),
+        ("f16", 1e-3, 1e-3),
+        ("bf16", 1e-2, 1e-2),
+    ]
+    print(f"Testing Ops.paged_attention on {args.device}")
+    for shape in testShapes:
+        for dtype_name, atol, rtol in testDtypePrec:
+            test_op_paged_attention(
+                *shape, dtype_name, atol, rtol, args.device, args.profile
+            )
+    # cache stored narrower than q: converted (or dequantized) inside the kernel
+    for shape in testShapes:
+        for cache_dtype_name in ["f16", "bf16", "i8"]:
+            test_op_paged_attention_cache_dtype(*shape, cache_dtype_name, device_name=args.device)
+
+    print("\033[92mTest passed!\033[0m\n")
@@ -0,0 +1,226 @@
+import sys
+import os
+
+parent_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+sys.path.insert(0, parent_dir)
+import llaisys
+import torch
+from test_utils import random_tensor, zero_tensor, check_equal, benchmark
+
+
+def torch_quantize(w):
+    amax = w.float().abs().amax(dim=-1)
+    scale = amax / 127.0
+    inv = torch.where(amax > 0, 127.0 / amax, torch.zeros_like(amax))
+    q = torch.round(w.float() * inv[:, None]).clamp(-127, 127).to(torch.int8)
+    return q, scale
+
+
+def test_op_quantize(
+    w_shape,
+    dtype_name="f32",
+    device_name="cpu",
+):
+    print(f"   quantize w {w_shape}, dtype <{dtype_name}>")
+    w, w_ = random_tensor(w_shape, dtype_name, device_name, scale=0.02, bias=-0.01)
+    _, q_ = zero_tensor(w_shape, "i8", device_name)
+    _, scale_ = zero_tensor((w_shape[0],), "f32", device_name)
+
+    q, scale = torch_quantize(w)
+    llaisys.Ops.quantize(q_, scale_, w_)
+
+    assert check_equal(scale_, scale, atol=1e-7, rtol=1e-6)
+    # Values exactly halfway between two steps may round either way.
+    assert check_equal(q_, q, atol=1, rtol=0)
+
+
+def torch_dequantize_q4(q, scale, zero, K):
+    # Each 32-value block is 16 bytes: low nibbles hold values 0..15, high nibbles 16..31.
+    blocks = q.view(torch.uint8).reshape(q.shape[0], K // 32, 16).to(torch.int32)
+    values = torch.cat([blocks & 0x0F, blocks >> 4], dim=-1).reshape(q.shape[0], K)
+    group = K // scale.shape[1]
+    z = zero.to(torch.float32) if zero is not None else torch.full_like(scale, 8, dtype=torch.float32)
+    z = z.repeat_interleave(group, dim=1)
+    s = scale.to(torch.float32).repeat_interleave(group, dim=1)
+    return (values.to(torch.float32) - z) * s
+
+
+def quantize_q4(w_, w_shape, group, use_zero, device_name):
+    N, K = w_shape
+    _, q_ = zero_tensor((N, K // 2), "u8", device_name)
+    _, scale_ = zero_tensor((N, K // group), "f16", device_name)
+    zero_ = zero_tensor((N, K // group), "u8", device_name)[1] if use_zero else None
+    llaisys.Ops.quantize(q_, scale_, w_, zero_)
+    return q_, scale_, zero_
+
+
+def to_torch(t_, shape, dtype_name):
+    t, _ = zero_tensor(shape, dtype_name, "cpu")
+    api = llaisys.RuntimeAPI(llaisys.DeviceType.CPU)
+    api.memcpy_sync(t.data_ptr(), t_.data_ptr(), t.numel() * t.element_size(), llaisys.MemcpyKind.D2D)
+    return t
+
+
+def test_op_quantize_q4(
+    w_shape,
+    group,
+    use_zero,
+    dtype_name="f32",
+    device_name="cpu",
+):
+    print(f"   quantize q4 w {w_shape}, group {group}, zero point {use_zero}, dtype <{dtype_name}>")
+    N, K = w_shape
+    w, w_ = random_tensor(w_shape, dtype_name, device_name, scale=0.02, bias=-0.01)
+    q_, scale_, zero_ = quantize_q4(w_, w_shape, group, use_zero, device_name)
+
+    scale = to_torch(scale_, (N, K // group), "f16")
+    zero = to_torch(zero_, (N, K // group), "u8") if use_zero else None
+    w_deq = torch_dequantize_q4(to_torch(q_, (N, K // 2), "u8"), scale, zero, K)
+
+    # Rounding error is half a step; a rounded zero point can add another half at the group edges.
+    step = scale.to(torch.float32).repeat_interleave(group, dim=1)
+    bound = step * (1.0 if use_zero else 0.5) * 1.01 + 1e-6
+    assert torch.all((w_deq - w.float()).abs() <= bound)
+
+
+def test_op_linear_q4(
+    out_shape,
+    x_shape,
+    w_shape,
+    group,
+    use_zero,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+    profile=False,
+):
+    print(f"   linear q4 out {out_shape}, x {x_shape}, w {w_shape}, group {group}, zero point {use_zero}, dtype <{dtype_name}>")
+    N, K = w_shape
+    x, x_ = random_tensor(x_shape, dtype_name, device_name, scale=0.1)
+    w, w_ = random_tensor(w_shape, "bf16", device_name, scale=0.02, bias=-0.01)
+    q_, scale_, zero_ = quantize_q4(w_, w_shape, group, use_zero, device_name)
+    zero = to_torch(zero_, (N, K // group), "u8") if use_zero else None
+    w_deq = torch_dequantize_q4(
+        to_torch(q_, (N, K // 2), "u8"), to_torch(scale_, (N, K // group), "f16"), zero, K
+    ).to(x.dtype)
+
+    out, out_ = random_tensor(out_shape, dtype_name, device_name)
+    torch.nn.functional.linear(x, w_deq, None, out=out)
+    llaisys.Ops.linear_quantized(out_, x_, q_, scale_, None, zero_)
+    assert check_equal(out_, out, atol=atol, rtol=rtol)
+
+    # The same packed table also serves as a quantized embedding.
+    index = torch.tensor([0, N - 1, N // 2], dtype=torch.int64)
+    index_ = llaisys.Tensor((3,), dtype=llaisys.DataType.I64)
+    index_.load(index.data_ptr())
+    embed, embed_ = random_tensor((3, K), dtype_name, device_name)
+    llaisys.Ops.embedding_quantized(embed_, index_, q_, scale_, zero_)
+    assert check_equal(embed_, w_deq[index], atol=atol, rtol=rtol)
+
+    if profile:
+        torch_time, llaisys_time = benchmark(
+            lambda: torch.nn.functional.linear(x, w_deq, None, out=out),
+            lambda: llaisys.Ops.linear_quantized(out_, x_, q_, scale_, None, zero_),
+            device_name,
+        )
+        weight_bytes = N * K // 2 + N * (K // group) * 2
+        print(f"        LLAISYS: {weight_bytes / llaisys_time / 1e9:.2f} GB/s q4 weights")
+
+
+def test_op_linear_quantized(
+    out_shape,
+    x_shape,
+    w_shape,
+    use_bias=True,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+    profile=False,
+):
+    print(f"   linear_quantized out {out_shape}, x {x_shape}, w {w_shape}, bias {use_bias}, dtype <{dtype_name}>")
+    x, x_ = random_tensor(x_shape, dtype_name, device_name, scale=0.1)
+    w, w_ = random_tensor(w_shape, "f32", device_name, scale=0.02, bias=-0.01)
+    _, q_ = zero_tensor(w_shape, "i8", device_name)
+    _, scale_ = zero_tensor((w_shape[0],), "f32", device_name)
+    llaisys.Ops.quantize(q_, scale_, w_)
+
+    # The reference multiplies by the dequantized weight the kernel sees.
+    q, scale = torch_quantize(w)
+    w_deq = (q.float() * scale[:, None]).to(x.dtype)
+
+    bias, bias_ = None, None
+    if use_bias:
+        bias, bias_ = random_tensor((w_shape[0],), dtype_name, device_name)
+
+    out, out_ = random_tensor(out_shape, dtype_name, device_name)
+    torch.nn.functional.linear(x, w_deq, bias, out=out)
+    llaisys.Ops.linear_quantized(out_, x_, q_, scale_, bias_)
+
+    assert check_equal(out_, out, atol=atol, rtol=rtol)
+
+    if profile:
+        torch_time, llaisys_time = benchmark(
+            lambda: torch.nn.functional.linear(x, w_deq, bias, out=out),
+            lambda: llaisys.Ops.linear_quantized(out_, x_, q_, scale_, bias_),
+            device_name,
+        )
+        # torch runs on the dequantized F32 weight, llaisys streams the INT8 one
+        weight_bytes = w.numel()
+        print(
+            f"        LLAISYS: {weight_bytes / llaisys_time / 1e9:.2f} GB/s INT8 weights"
+        )
+
+
+if __name__ == "__main__":
+    import argparse
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--device", default="cpu", choices=["cpu", "nvidia"], type=str)
+    parser.add_argument("--profile", action="store_true")
+    args = parser.parse_args()
+
+    print(f"Testing Ops.quantize on {args.device}")
+    for w_shape in [(3, 4), (129, 300), (1536, 1536)]:
+        for dtype_name in ["f32", "f16", "bf16"]:
+            test_op_quantize(w_shape, dtype_name, args.device)
+
+    testShapes = [
+        ((2, 3), (2, 4), (3, 4), True),
+        ((1, 1536), (1, 1536), (1536, 1536), True),
+        ((128, 8960), (128, 1536), (8960, 1536), False),
+    ]
+    testDtypePrec = [
+        # type, atol, rtol
+        ("f32", 1e-4, 1e-4),
+        ("f16", 1e-3, 1e-3),
+        ("bf16", 1e-2, 1e-2),
+    ]
+    print(f"Testing Ops.linear_quantized on {args.device}")
+    for shapes in testShapes:
+        for dtype_name, atol, rtol in testDtypePrec:
+            test_op_linear_quantized(*shapes, dtype_name, atol, rtol, args.device, args.profile)
+
+    print(f"Testing Ops.quantize (q4) on {args.device}")
+    for w_shape in [(3, 64), (129, 384), (1536, 1536)]:
+        for group in [32, 64, 128]:
+            if w_shape[1] % group:
+                continue
+            for use_zero in [False, True]:
+                for dtype_name in ["f32", "bf16"]:
+                    test_op_quantize_q4(w_shape, group, use_zero, dtype_name, args.device)
+
+    testQ4Shapes = [
+        ((2, 3), (2, 64), (3, 64)),
+        ((1, 1536), (1, 1536), (1536, 1536)),
+        ((128, 8960), (128, 1536), (8960, 1536)),
+    ]
+    print(f"Testing Ops.linear_quantized (q4) on {args.device}")
+    for shapes in testQ4Shapes:
+        for group in [32, 64]:
+            for use_zero in [False, True]:
+                for dtype_name, atol, rtol in testDtypePrec:
+                    test_op_linear_q4(*shapes, group, use_zero, dtype_name, atol, rtol, args.device, args.profile)
+
+    print("\033[92mTest passed!\033[0m\n")
@@ -1,11 +1,12 @@
 import sys
 import os
+import math
 
 parent_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
 sys.path.insert(0, parent_dir)
 import llaisys
 import torch
-from test_utils import arrange_tensor, random_tensor, check_equal, benchmark
+from test_utils import arrange_tensor, random_tensor, zero_tensor, check_equal, benchmark
 
 
 def torch_rope(y: torch.Tensor, x: torch.Tensor, pos_ids: torch.Tensor, theta: float):
@@ -59,6 +60,85 @@ def test_op_rope(
         )
 
 
+def test_op_rope_strided(
+    shape,
+    start_end,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+):
+    # 输入输出都是更宽张量中按头切出的视图 (如融合 QKV 的输出)，token 之间有间隔
+    seq_len, n_heads, head_dim = shape
+    print(f"   strided shape {shape} range {start_end} dtype <{dtype_name}>")
+    x, x_ = random_tensor((seq_len, 3 * n_heads, head_dim), dtype_name, device_name)
+    pos_ids, pos_ids_ = arrange_tensor(start_end[0], start_end[1], device_name)
+    theta = 10000.0
+    y, y_ = random_tensor((seq_len, 2 * n_heads, head_dim), dtype_name, device_name)
+    torch_rope(y[:, n_heads:], x[:, n_heads : 2 * n_heads], pos_ids, theta)
+    llaisys.Ops.rope(
+        y_.slice(1, n_heads, 2 * n_heads), x_.slice(1, n_heads, 2 * n_heads), pos_ids_, theta
+    )
+
+    assert check_equal(y_, y, atol=atol, rtol=rtol)
+
+
+def to_torch(t_, shape, dtype_name):
+    t, _ = zero_tensor(shape, dtype_name, "cpu")
+    api = llaisys.RuntimeAPI(llaisys.DeviceType.CPU)
+    api.memcpy_sync(t.data_ptr(), t_.data_ptr(), t.numel() * t.element_size(), llaisys.MemcpyKind.D2D)
+    return t
+
+
+def test_op_rope_table(
+    shape,
+    start_end,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+    profile=False,
+):
+    # 预先算好的 cos/sin 表: 查表结果须与逐元素计算逐位相同
+    seq_len, n_heads, head_dim = shape
+    print(f"   table shape {shape} range {start_end} dtype <{dtype_name}>")
+    x, x_ = random_tensor(shape, dtype_name, device_name)
+    pos_ids, pos_ids_ = arrange_tensor(start_end[0], start_end[1], device_name)
+    theta = 10000.0
+    _, table_ = zero_tensor((start_end[1] + 3, 2, head_dim // 2), "f32", device_name)
+    llaisys.Ops.rope_table(table_, theta)
+    y, y_ = random_tensor(shape, dtype_name, device_name)
+    _, direct_ = random_tensor(shape, dtype_name, device_name)
+    torch_rope(y, x, pos_ids, theta)
+    llaisys.Ops.rope(y_, x_, pos_ids_, theta, table=table_)
+    llaisys.Ops.rope(direct_, x_, pos_ids_, theta)
+
+    assert check_equal(y_, y, atol=atol, rtol=rtol)
+    assert check_equal(y_, to_torch(direct_, shape, dtype_name), strict=True)
+
+    if profile:
+        benchmark(
+            lambda: llaisys.Ops.rope(direct_, x_, pos_ids_, theta),
+            lambda: llaisys.Ops.rope(y_, x_, pos_ids_, theta, table=table_),
+            device_name,
+        )
+
+
+def test_op_rope_table_reference(max_pos, head_dim, theta, device_name="cpu"):
+    # 表须与双精度参考逐位相同: 角度按 double 计算，cos/sin 各舍入一次到 float
+    print(f"   table reference max_pos {max_pos} head_dim {head_dim} theta {theta}")
+    half_dim = head_dim // 2
+    _, table_ = zero_tensor((max_pos, 2, half_dim), "f32", device_name)
+    llaisys.Ops.rope_table(table_, theta)
+    freqs = [math.pow(theta, -2.0 * j / head_dim) for j in range(half_dim)]
+    ref = [
+        [[math.cos(p * f) for f in freqs], [math.sin(p * f) for f in freqs]] for p in range(max_pos)
+    ]
+    ref = torch.tensor(ref, dtype=torch.float64).to(torch.float32)
+
+    assert check_equal(table_, ref, strict=True)
+
+
 if __name__ == "__main__":
     import argparse
 
@@ -79,5 +159,12 @@ if __name__ == "__main__":
     for shape, start_end in testShapes:
         for dtype_name, atol, rtol in testDtypePrec:
             test_op_rope(shape, start_end, dtype_name, atol, rtol, args.device, args.profile)
+    for dtype_name, atol, rtol in testDtypePrec:
+        test_op_rope_strided((5, 2, 8), (3, 8), dtype_name, atol, rtol, args.device)
+    for shape, start_end in [((5, 2, 8), (3, 8)), ((512, 4, 4096), (512, 1024))]:
+        for dtype_name, atol, rtol in testDtypePrec:
+            test_op_rope_table(shape, start_end, dtype_name, atol, rtol, args.device, args.profile)
+    for max_pos, head_dim, theta in [(64, 8, 10000.0), (4096, 128, 10000.0), (2048, 64, 1000000.0)]:
+        test_op_rope_table_reference(max_pos, head_dim, theta, args.device)
 
     print("\033[92mTest passed!\033[0m\n")
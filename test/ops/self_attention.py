@@ -72,6 +72,13 @@ if __name__ == "__main__":
         # qlen, kvlen, nh, nkvh, hd
         (2, 2, 1, 1, 4),
         (5, 11, 4, 2, 8),
+        # spans several K/V tiles and query blocks
+        (1, 100, 12, 2, 64),
+        (19, 70, 8, 2, 32),
+        # query group wider than one row block
+        (3, 40, 20, 1, 16),
+        # decode on a long cache, split over the keys
+        (1, 1024, 4, 2, 32),
     ]
     testDtypePrec = [
         # type, atol, rtol
@@ -55,8 +55,8 @@ def hf_infer(
     return outputs[0].tolist(), result
 
 
-def load_llaisys_model(model_path, device_name):
-    model = llaisys.models.Qwen2(model_path, llaisys_device(device_name))
+def load_llaisys_model(model_path, device_name, quantize=None):
+    model = llaisys.models.Qwen2(model_path, llaisys_device(device_name), quantize=quantize)
     return model
 
 
@@ -90,6 +90,9 @@ if __name__ == "__main__":
     parser.add_argument("--top_k", default=50, type=int)
     parser.add_argument("--temperature", default=1.0, type=float)
     parser.add_argument("--test", action="store_true")
+    # Also run the model with quantized projection weights and report
+    # token agreement and tokens/s against the unquantized run.
+    parser.add_argument("--quantize", default=None, choices=["int8", "q4"], type=str)
 
     args = parser.parse_args()
 
@@ -144,6 +147,39 @@ if __name__ == "__main__":
     print(llaisys_output)
     print("\n")
     print(f"Time elapsed: {(end_time - start_time):.2f}s\n")
+    llaisys_elapsed = end_time - start_time
+
+    if args.quantize:
+        del model
+        gc.collect()
+
+        model = load_llaisys_model(model_path, args.device, quantize=args.quantize)
+        start_time = time.time()
+        quant_tokens, quant_output = llaisys_infer(
+            args.prompt,
+            tokenizer,
+            model,
+            max_new_tokens=args.max_steps,
+            top_p=top_p,
+            top_k=top_k,
+            temperature=temperature,
+        )
+        end_time = time.time()
+        quant_elapsed = end_time - start_time
+
+        n = min(len(quant_tokens), len(llaisys_tokens))
+        matched = sum(a == b for a, b in zip(quant_tokens, llaisys_tokens))
+        diverge = next(
+            (i for i in range(n) if quant_tokens[i] != llaisys_tokens[i]), None
+        )
+        print(f"\n=== Quantized ({args.quantize}) Result ===\n")
+        print("Contents:")
+        print(quant_output)
+        print("\n")
+        print(f"Token agreement: {matched}/{max(len(quant_tokens), len(llaisys_tokens))}")
+        print(f"First divergence: {'none' if diverge is None else diverge}")
+        print(f"Unquantized: {len(llaisys_tokens) / llaisys_elapsed:.2f} tokens/s")
+        print(f"Quantized:   {len(quant_tokens) / quant_elapsed:.2f} tokens/s\n")
 
     if args.test:
         #assert llaisys_tokens == tokens
@@ -1,3 +1,6 @@
+import os
+import sys
+
 import llaisys
 import torch
 from test_utils import *
@@ -53,10 +56,71 @@ def test_memcpy(api, size_bytes: int):
     torch.testing.assert_close(a, b)
 
 
+def test_thread_pool():
+    print("Testing cpu thread pool...")
+    x, x_ = random_tensor((37, 300), "f32", "cpu", scale=0.1)
+    w, w_ = random_tensor((129, 300), "f32", "cpu", scale=0.01)
+    out, out_ = random_tensor((37, 129), "f32", "cpu")
+    expected = x @ w.T
+
+    default_threads = llaisys.get_num_threads()
+    assert default_threads >= 1
+    for num_threads in [1, 2, 4, 7]:
+        llaisys.set_num_threads(num_threads)
+        assert llaisys.get_num_threads() == num_threads
+        llaisys.Ops.linear(out_, x_, w_, None)
+        assert check_equal(out_, expected, atol=1e-5, rtol=1e-5)
+    llaisys.set_num_threads(0)
+    assert llaisys.get_num_threads() == default_threads
+
+    print("     Passed")
+
+
+def worker_affinities():
+    # 线程池的 worker 线程名为 llaisys-worker，逐个读回其 CPU 亲和性
+    result = []
+    for tid in os.listdir("/proc/self/task"):
+        try:
+            with open(f"/proc/self/task/{tid}/comm") as f:
+                name = f.read().strip()
+            if name == "llaisys-worker":
+                result.append(sorted(os.sched_getaffinity(int(tid))))
+        except (FileNotFoundError, ProcessLookupError):
+            continue
+    return sorted(result)
+
+
+def test_thread_affinity():
+    print("Testing cpu thread affinity...")
+    if not sys.platform.startswith("linux"):
+        print("     Skipped")
+        return
+    cpus = sorted(os.sched_getaffinity(0))
+    num_threads = 5
+    llaisys.set_num_threads(num_threads)
+
+    # worker k (k >= 1) 绑定 cpu_ids[1 + (k - 1) % (n - 1)]，cpu_ids[0] 留给调用线程
+    for n in [2, 3, 5]:
+        cpu_ids = [cpus[i % len(cpus)] for i in range(n)]
+        llaisys.set_thread_affinity(cpu_ids)
+        expected = sorted([cpu_ids[1 + (k - 1) % (n - 1)]] for k in range(1, num_threads))
+        assert worker_affinities() == expected, (cpu_ids, worker_affinities())
+    # 只有一个 id 或为空时 worker 不绑定，沿用调用线程的亲和性
+    for cpu_ids in [[cpus[-1]], []]:
+        llaisys.set_thread_affinity(cpu_ids)
+        assert worker_affinities() == [cpus] * (num_threads - 1)
+
+    llaisys.set_num_threads(0)
+    print("     Passed")
+
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser()
     parser.add_argument("--device", default="cpu", choices=["cpu", "nvidia"], type=str)
     args = parser.parse_args()
     test_basic_runtime_api(args.device)
+    if args.device == "cpu":
+        test_thread_pool()
+        test_thread_affinity()
     
     print("\033[92mTest passed!\033[0m\n")
@@ -0,0 +1,133 @@
+import argparse
+import os
+import random
+import threading
+import time
+
+from huggingface_hub import snapshot_download
+import llaisys
+from test_utils import llaisys_device
+
+
+def greedy(model, prompt, max_new_tokens):
+    """单序列接口逐 token 生成，作为调度器输出的参照"""
+    tokens = [model.prefill(prompt, 0)]
+    pos = len(prompt)
+    while len(tokens) < max_new_tokens:
+        tokens.append(model.forward(tokens[-1], pos))
+        pos += 1
+    return tokens
+
+
+def run_streams(scheduler, prompts, max_new_tokens):
+    """每个流一个线程提交请求并逐批取回 token，返回 (总耗时, 所有 token 间隔, 各流输出)"""
+    gaps = [[] for _ in prompts]
+    outputs = [[] for _ in prompts]
+
+    def client(i):
+        request_id = scheduler.submit(prompts[i], max_new_tokens, eos_token=-1)
+        last = None
+        finished = False
+        while not finished:
+            tokens, finished = scheduler.poll(request_id, timeout_ms=-1)
+            now = time.perf_counter()
+            if tokens:
+                # 一次取回多个 token 时按个数均摊间隔
+                if last is not None:
+                    gaps[i].extend([(now - last) / len(tokens)] * len(tokens))
+                last = now
+                outputs[i].extend(tokens)
+
+    threads = [threading.Thread(target=client, args=(i,)) for i in range(len(prompts))]
+    start = time.perf_counter()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    return time.perf_counter() - start, sorted(g for s in gaps for g in s), outputs
+
+
+def test_pool_exhaustion(model_path, device):
+    """KV block 池在批量 decode 中途用尽时整批失败，已分到 block 的序列也保持原长度"""
+    # 1.5B 的 F32 KV 每个 16-token block 约 0.9MB，2MB 的池恰好两个 block
+    model = llaisys.models.Qwen2(
+        model_path, llaisys_device(device), kv_block_size=16, prefix_cache_mb=0, kv_cache_mb=2
+    )
+    rng = random.Random(1)
+    vocab = model.config.vocab_size
+    a = [rng.randrange(vocab) for _ in range(15)]  # 一个 block，还剩一个空位
+    b = [rng.randrange(vocab) for _ in range(16)]  # 一个 block，池已满
+    next_a = model.prefill_sequence(1, a)
+    next_b = model.prefill_sequence(2, b)
+    try:
+        model.forward_batch([1, 2], [next_a, next_b], [15, 16])
+        raise AssertionError("forward_batch succeeded on a full KV pool")
+    except RuntimeError:
+        pass
+    # 序列 1 的新 token 放得下，但整批失败后它仍只有 15 个 token
+    model.release_sequence(2)
+    try:
+        model.forward_batch([1], [next_a], [16])
+        raise AssertionError("sequence 1 kept a token whose K/V was never written")
+    except RuntimeError:
+        pass
+    model.forward_batch([1], [next_a], [15])
+    del model
+
+
+def percentile(sorted_values, q):
+    if not sorted_values:
+        return 0.0
+    return sorted_values[min(len(sorted_values) - 1, int(len(sorted_values) * q))]
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--device", default="cpu", choices=["cpu", "nvidia"], type=str)
+    parser.add_argument("--model", default=None, type=str)
+    parser.add_argument("--streams", default="1,4,16,64", type=str)
+    parser.add_argument("--prompt_len", default=64, type=int)
+    parser.add_argument("--max_steps", default=64, type=int)
+    parser.add_argument("--prefill_budget", default=0, type=int)
+    # 先检查调度器的输出与逐个请求 greedy 生成一致
+    parser.add_argument("--test", action="store_true")
+    args = parser.parse_args()
+
+    model_path = args.model
+    if not (model_path and os.path.isdir(model_path)):
+        model_path = snapshot_download("deepseek-ai/DeepSeek-R1-Distill-Qwen-1.5B")
+    if args.test:
+        test_pool_exhaustion(model_path, args.device)
+    model = llaisys.models.Qwen2(model_path, llaisys_device(args.device), prefix_cache_mb=0)
+
+    rng = random.Random(0)
+    vocab = model.config.vocab_size
+    streams = [int(s) for s in args.streams.split(",")]
+    prompts = [[rng.randrange(vocab) for _ in range(args.prompt_len)] for _ in range(max(streams))]
+
+    expected = None
+    if args.test:
+        expected = [greedy(model, p, args.max_steps) for p in prompts[:4]]
+    # 单序列基线: 请求逐个串行执行
+    start = time.perf_counter()
+    for p in prompts[:4]:
+        greedy(model, p, args.max_steps)
+    serial = 4 * args.max_steps / (time.perf_counter() - start)
+    print(f"serial: {serial:.2f} tokens/s")
+
+    scheduler = llaisys.models.Qwen2Scheduler(model, max_batch=max(streams), prefill_budget=args.prefill_budget)
+    for n in streams:
+        elapsed, gaps, outputs = run_streams(scheduler, prompts[:n], args.max_steps)
+        print(
+            f"streams {n:3d}: {n * args.max_steps / elapsed:8.2f} tokens/s, "
+            f"inter-token latency p50 {percentile(gaps, 0.5) * 1e3:7.2f} ms, "
+            f"p99 {percentile(gaps, 0.99) * 1e3:7.2f} ms"
+        )
+        # 超过 4 个流时 decode 的投影层走分块 GEMM (按 K 切片求和后再累加)，与单序列 GEMV 的
+        # 单链 FMA 舍入不同，接近并列的 argmax 可能翻转，只对 <= 4 个流逐 token 比较
+        if expected is not None and n <= 4:
+            for i in range(min(n, len(expected))):
+                assert outputs[i] == expected[i], f"stream {i} differs from greedy decoding"
+
+    if args.test:
+        print("\033[92mTest passed!\033[0m\n")
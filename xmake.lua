@@ -62,6 +62,9 @@ target("llaisys-core")
     end
 
     add_files("src/core/*/*.cpp")
+    if is_plat("linux") then
+        add_syslinks("pthread")
+    end
 
     on_install(function (target) end)
 target_end()
@@ -113,6 +116,9 @@ target("llaisys")
     -- 添加模型的 C API 接口代码
     add_files("src/llaisys/models/*.cpp")
     set_installdir(".")
+    if is_plat("linux") then
+        add_syslinks("pthread")
+    end
 
     
     after_install(function (target)
@@ -1,3 +1,21 @@
+option("cpu-avx2")
+    set_default(true)
+    set_showmenu(true)
+    set_description("Whether to compile cpu kernels with AVX2/FMA/F16C")
+option_end()
+
+option("cpu-avx512")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Whether to compile cpu kernels with AVX-512")
+option_end()
+
+option("cpu-fast-math")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Whether to use the faster, less accurate exp / sigmoid / silu in cpu kernels")
+option_end()
+
 target("llaisys-device-cpu")
     set_kind("static")
     set_languages("cxx17")
@@ -20,6 +38,26 @@ target("llaisys-ops-cpu")
         add_cxflags("-fPIC", "-Wno-unknown-pragmas")
     end
 
+    if has_config("cpu-avx512") then
+        if is_plat("windows") then
+            add_cxflags("/arch:AVX512")
+        else
+            add_cxflags("-mavx512f", "-mavx512bw", "-mavx512vl", "-mavx512dq", "-mfma", "-mf16c")
+            -- gcc 12 reports false positives inside its own avx512 intrinsic headers
+            add_cxflags("-Wno-maybe-uninitialized")
+        end
+    elseif has_config("cpu-avx2") then
+        if is_plat("windows") then
+            add_cxflags("/arch:AVX2")
+        else
+            add_cxflags("-mavx2", "-mfma", "-mf16c")
+        end
+    end
+
+    if has_config("cpu-fast-math") then
+        add_defines("LLAISYS_FAST_MATH")
+    end
+
     add_files("../src/ops/*/cpu/*.cpp")
 
     on_install(function (target) end)